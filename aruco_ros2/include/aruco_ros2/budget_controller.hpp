@@ -0,0 +1,68 @@
+#ifndef ARUCO_ROS2__BUDGET_CONTROLLER_HPP_
+#define ARUCO_ROS2__BUDGET_CONTROLLER_HPP_
+
+#include <atomic>
+#include <mutex>
+
+#include <opencv2/aruco.hpp>
+
+namespace aruco_ros2
+{
+
+struct BudgetControllerConfig
+{
+    // Detection time per input frame to stay under
+    double target_ms = 33.0;
+    // Weight of the newest sample in the moving average
+    double smoothing = 0.2;
+    // Effort is raised again once the average drops below relax_ratio * target_ms
+    double relax_ratio = 0.6;
+    // Frames to wait after a change before lowering / raising effort again, so the average reflects
+    // the new level. Lowering reacts faster than raising to avoid oscillating around the target.
+    int lower_hold_frames = 5;
+    int raise_hold_frames = 30;
+};
+
+// Feedback controller that trades detection effort for time. Each frame's detection time goes in; an
+// effort level comes out, 0 being the configured settings and each level above it giving up a little
+// more recall for speed (see applyEffortLevel). Thread-safe: samples from concurrent workers that find
+// the controller busy are dropped rather than waited for.
+class BudgetController
+{
+public:
+    static constexpr int kMaxLevel = 6;
+
+    explicit BudgetController(const BudgetControllerConfig &config);
+
+    // Feeds the detection time of one frame, already divided by the current frame stride. Returns true
+    // if the effort level changed.
+    bool addSample(double detection_ms);
+
+    int level() const { return level_.load(std::memory_order_relaxed); }
+    double average_ms() const;
+
+private:
+    BudgetControllerConfig config_;
+    mutable std::mutex mutex_;
+    double average_ms_ = 0.0;
+    bool have_average_ = false;
+    int frames_since_change_ = 0;
+    std::atomic<int> level_{0};
+};
+
+// Reduces the detection effort of `params` and `pyramid_level` for effort level `level`. The levels are
+// cumulative:
+//   1 - half as many adaptive-threshold window scales
+//   2 - a single threshold scale, smallest candidates (perimeter) ignored
+//   3 - detection one pyramid level coarser
+//   4 - two pyramid levels coarser, larger minimum perimeter
+//   5 - every second frame skipped (see frameStride)
+//   6 - two of every three frames skipped
+void applyEffortLevel(int level, cv::aruco::DetectorParameters &params, int &pyramid_level);
+
+// Only every frameStride(level)-th input frame is processed
+int frameStride(int level);
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__BUDGET_CONTROLLER_HPP_
@@ -0,0 +1,78 @@
+#ifndef ARUCO_ROS2__CAMERA_CALIBRATION_HPP_
+#define ARUCO_ROS2__CAMERA_CALIBRATION_HPP_
+
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace aruco_ros2
+{
+
+// Lens models of sensor_msgs/CameraInfo (distortion_models.hpp) that the node can undistort
+enum class DistortionModel
+{
+    PlumbBob,           // k1, k2, p1, p2[, k3]
+    RationalPolynomial, // k1, k2, p1, p2, k3, k4, k5, k6
+    Equidistant,        // fisheye k1, k2, k3, k4
+};
+
+// Parses a CameraInfo distortion_model name; an empty name is plumb_bob. Returns false if unknown.
+bool parseDistortionModel(const std::string &name, DistortionModel &model);
+const char *distortionModelName(DistortionModel model);
+
+// Everything derived from one camera calibration. Corner points are mapped to normalized, undistorted
+// image coordinates through a lookup table sampled every kTableStep pixels over the image and
+// interpolated bilinearly, so no distortion model has to be inverted per frame. Building the table
+// costs one iterative undistortion per table node, so instances are created once per distinct
+// calibration and shared, read-only, by every frame that uses it.
+class CameraCalibration
+{
+public:
+    // An empty `distortion` is taken as all coefficients zero
+    CameraCalibration(const cv::Size &image_size, const cv::Mat &camera_matrix, const cv::Mat &distortion,
+                      DistortionModel model = DistortionModel::PlumbBob);
+
+    // True if this instance was built from the same values, i.e. nothing needs to be rebuilt
+    bool matches(const cv::Size &image_size, const cv::Mat &camera_matrix, const cv::Mat &distortion,
+                 DistortionModel model = DistortionModel::PlumbBob) const;
+
+    const cv::Size &imageSize() const { return image_size_; }
+    const cv::Mat &cameraMatrix() const { return camera_matrix_; }
+    const cv::Mat &distortion() const { return distortion_; }
+    DistortionModel model() const { return model_; }
+
+    // Maps pixel coordinates to normalized, undistorted coordinates (pose can then be solved with an
+    // identity camera matrix and no distortion). `normalized` is resized to match `pixels`.
+    void undistort(const std::vector<cv::Point2f> &pixels, std::vector<cv::Point2f> &normalized) const;
+
+    // Projects object points with this calibration's lens model. `camera_matrix` may differ from the
+    // calibrated one (e.g. scaled for a smaller overlay image); pass an empty Mat to use the calibrated one.
+    void project(const std::vector<cv::Point3f> &object_points, const cv::Vec3d &rvec, const cv::Vec3d &tvec,
+                 const cv::Mat &camera_matrix, std::vector<cv::Point2f> &image_points) const;
+
+private:
+    // Table resolution in pixels. The distortion field is smooth enough that bilinear interpolation at
+    // this spacing stays well below the corner localisation noise.
+    static constexpr int kTableStep = 8;
+
+    void buildTable();
+    void undistortExact(const std::vector<cv::Point2f> &pixels, std::vector<cv::Point2f> &normalized) const;
+
+    cv::Size image_size_;
+    cv::Mat camera_matrix_;
+    cv::Mat distortion_;
+    DistortionModel model_;
+    bool has_distortion_ = false;
+
+    // Pinhole inverse, used directly when there is no distortion
+    double fx_ = 1.0, fy_ = 1.0, cx_ = 0.0, cy_ = 0.0, skew_ = 0.0;
+
+    int table_cols_ = 0;
+    int table_rows_ = 0;
+    std::vector<cv::Point2f> table_; // row-major, node (c, r) at pixel (c * kTableStep, r * kTableStep)
+};
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__CAMERA_CALIBRATION_HPP_
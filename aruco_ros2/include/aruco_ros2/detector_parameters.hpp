@@ -0,0 +1,70 @@
+#ifndef ARUCO_ROS2__DETECTOR_PARAMETERS_HPP_
+#define ARUCO_ROS2__DETECTOR_PARAMETERS_HPP_
+
+#include <string>
+#include <vector>
+
+#include <opencv2/aruco.hpp>
+
+namespace aruco_ros2
+{
+
+// Calls visitor(name, field) for every field of cv::aruco::DetectorParameters, with `field` a reference
+// of the field's own type (int, double, float or bool). The node uses it to declare, read and log the
+// detector.* parameters from one list.
+template <typename Params, typename Visitor>
+void visitDetectorParameters(Params &p, Visitor &&visitor)
+{
+    // Thresholding and contour filtering
+    visitor("adaptiveThreshWinSizeMin", p.adaptiveThreshWinSizeMin);
+    visitor("adaptiveThreshWinSizeMax", p.adaptiveThreshWinSizeMax);
+    visitor("adaptiveThreshWinSizeStep", p.adaptiveThreshWinSizeStep);
+    visitor("adaptiveThreshConstant", p.adaptiveThreshConstant);
+    visitor("minMarkerPerimeterRate", p.minMarkerPerimeterRate);
+    visitor("maxMarkerPerimeterRate", p.maxMarkerPerimeterRate);
+    visitor("polygonalApproxAccuracyRate", p.polygonalApproxAccuracyRate);
+    visitor("minCornerDistanceRate", p.minCornerDistanceRate);
+    visitor("minDistanceToBorder", p.minDistanceToBorder);
+    visitor("minMarkerDistanceRate", p.minMarkerDistanceRate);
+    // Corner refinement (0 none, 1 subpix, 2 contour, 3 apriltag)
+    visitor("cornerRefinementMethod", p.cornerRefinementMethod);
+    visitor("cornerRefinementWinSize", p.cornerRefinementWinSize);
+    visitor("cornerRefinementMaxIterations", p.cornerRefinementMaxIterations);
+    visitor("cornerRefinementMinAccuracy", p.cornerRefinementMinAccuracy);
+    // Bit extraction and decoding
+    visitor("markerBorderBits", p.markerBorderBits);
+    visitor("perspectiveRemovePixelPerCell", p.perspectiveRemovePixelPerCell);
+    visitor("perspectiveRemoveIgnoredMarginPerCell", p.perspectiveRemoveIgnoredMarginPerCell);
+    visitor("maxErroneousBitsInBorderRate", p.maxErroneousBitsInBorderRate);
+    visitor("minOtsuStdDev", p.minOtsuStdDev);
+    visitor("errorCorrectionRate", p.errorCorrectionRate);
+    visitor("detectInvertedMarker", p.detectInvertedMarker);
+    // AprilTag corner refinement
+    visitor("aprilTagQuadDecimate", p.aprilTagQuadDecimate);
+    visitor("aprilTagQuadSigma", p.aprilTagQuadSigma);
+    visitor("aprilTagMinClusterPixels", p.aprilTagMinClusterPixels);
+    visitor("aprilTagMaxNmaxima", p.aprilTagMaxNmaxima);
+    visitor("aprilTagCriticalRad", p.aprilTagCriticalRad);
+    visitor("aprilTagMaxLineFitMse", p.aprilTagMaxLineFitMse);
+    visitor("aprilTagMinWhiteBlackDiff", p.aprilTagMinWhiteBlackDiff);
+    visitor("aprilTagDeglitch", p.aprilTagDeglitch);
+}
+
+// Names accepted by applyDetectorPreset
+std::vector<std::string> detectorPresetNames();
+
+// Resets `params` to OpenCV's defaults and applies the named preset on top:
+//   default  - OpenCV's defaults
+//   fast     - one adaptive-threshold scale, small markers ignored, no corner refinement
+//   balanced - two threshold scales, subpixel corner refinement
+//   accurate - many threshold scales, small markers kept, finer bit sampling and refinement
+// Returns false if the name is unknown.
+bool applyDetectorPreset(const std::string &name, cv::aruco::DetectorParameters &params);
+
+// Checks the combinations detectMarkers would reject (it asserts on them); on failure returns false
+// and describes the problem in `error`
+bool validateDetectorParameters(const cv::aruco::DetectorParameters &params, std::string &error);
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__DETECTOR_PARAMETERS_HPP_
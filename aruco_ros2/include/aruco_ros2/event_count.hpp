@@ -0,0 +1,86 @@
+#ifndef ARUCO_ROS2__EVENT_COUNT_HPP_
+#define ARUCO_ROS2__EVENT_COUNT_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+namespace aruco_ros2
+{
+
+// Lets a pipeline thread that found its SpscQueues empty sleep until a producer pushes, without a lock
+// or a syscall on the producer side while nobody is waiting. A waiter registers, re-checks its
+// condition, and only then blocks; a producer that publishes after the waiter registered sees it and
+// wakes it, so no notification is lost between the check and the wait.
+class EventCount
+{
+public:
+    // Blocks until `ready()` holds or notify() is called. `ready` is checked once after registering, so
+    // it must read the state the producers change before notifying.
+    template <typename Ready>
+    void wait(Ready ready)
+    {
+        const uint64_t epoch = prepare_wait();
+        if (ready())
+        {
+            cancel_wait();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&]
+                 { return epoch_.load(std::memory_order_relaxed) != epoch; });
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // As wait(), but returns after `timeout` at the latest
+    template <typename Ready>
+    void wait_for(Ready ready, std::chrono::steady_clock::duration timeout)
+    {
+        const uint64_t epoch = prepare_wait();
+        if (ready())
+        {
+            cancel_wait();
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait_for(lock, timeout, [&]
+                     { return epoch_.load(std::memory_order_relaxed) != epoch; });
+        waiters_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // Called by a producer after it made the waiters' condition true. Costs one load when nobody waits.
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters_.load(std::memory_order_relaxed) == 0)
+        {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            epoch_.fetch_add(1, std::memory_order_relaxed);
+        }
+        cv_.notify_all();
+    }
+
+private:
+    uint64_t prepare_wait()
+    {
+        waiters_.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return epoch_.load(std::memory_order_relaxed);
+    }
+
+    void cancel_wait() { waiters_.fetch_sub(1, std::memory_order_relaxed); }
+
+    std::atomic<uint32_t> waiters_{0};
+    std::atomic<uint64_t> epoch_{0};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__EVENT_COUNT_HPP_
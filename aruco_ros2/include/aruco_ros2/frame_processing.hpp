@@ -0,0 +1,85 @@
+#ifndef ARUCO_ROS2__FRAME_PROCESSING_HPP_
+#define ARUCO_ROS2__FRAME_PROCESSING_HPP_
+
+#include <string>
+#include <vector>
+
+#include <opencv2/aruco.hpp>
+#include <opencv2/core.hpp>
+
+#include "aruco_ros2/camera_calibration.hpp"
+#include "aruco_ros2/square_pose.hpp"
+
+namespace aruco_ros2
+{
+
+// Detection settings that can be changed while running. A new snapshot is built in the parameter
+// callback and swapped in between frames; every frame uses the snapshot it started detection with.
+struct DetectorConfig
+{
+    std::string dictionary_name;
+    cv::Ptr<cv::aruco::Dictionary> dictionary;
+    cv::Ptr<cv::aruco::DetectorParameters> parameters;
+    double marker_size = 0.1;
+    int pyramid_level = 0;
+};
+
+// Results of one frame and the buffers used to compute them. Reused from frame to frame, so once the
+// buffers have grown to the size of the input, processing a frame allocates almost nothing.
+struct FrameState
+{
+    // Detector settings actually used for this frame: the config's, reduced by the effort level.
+    // effort_parameters is the scratch copy for levels above 0.
+    int pyramid_level = 0;
+    cv::Ptr<cv::aruco::DetectorParameters> parameters;
+    cv::Ptr<cv::aruco::DetectorParameters> effort_parameters;
+    cv::Mat gray;
+    cv::Mat gray_buffer; // conversion target
+    std::vector<int> marker_ids;
+    std::vector<std::vector<cv::Point2f>> marker_corners, rejected_candidates;
+    std::vector<cv::Vec3d> rvecs; // only consumed by the overlay; a zero tvec marks a failed solve
+    std::vector<cv::Vec3d> tvecs;
+    // Pose solver scratch
+    std::vector<cv::Point2f> pixel_corners, normalized_corners;
+    SquarePoseBatch poses;
+    // ROI detection input and scratch
+    std::vector<cv::Rect> rois;
+    std::vector<int> roi_ids;
+    std::vector<std::vector<cv::Point2f>> roi_corners, roi_rejected;
+    // Downscaled image for coarse-to-fine detection
+    cv::Mat coarse_buffer;
+    std::vector<cv::Point2f> refine_points;
+};
+
+cv::aruco::PREDEFINED_DICTIONARY_NAME dictNameToEnum(const std::string &dict_name);
+
+// Sets state.gray to the single-channel image the detector works on. mono8 frames are used in place and
+// bgr8, rgb8, bgra8 and rgba8 are converted into state.gray_buffer. Returns false for other encodings
+// (sensor_msgs names), leaving the conversion to the caller.
+bool convertToGray(const cv::Mat &image, const std::string &encoding, FrameState &state);
+
+// Resolves the detector settings of the frame from the config and the budget controller's effort level
+void resolveDetectorSettings(const DetectorConfig &config, int effort_level, FrameState &state);
+
+// Full-frame detection. With pyramid_level > 0, candidates are found and decoded on an image
+// downscaled by 2^pyramid_level, and their corners are then refined on the full-resolution image, so
+// poses keep full-resolution accuracy.
+void detectFullFrame(const DetectorConfig &config, FrameState &state);
+
+// Detects on each of state.rois (views into the gray image, no copies) and merges the results in
+// full-image coordinates. The ROIs must not overlap, so nothing is found twice.
+void detectInRois(const DetectorConfig &config, FrameState &state);
+
+// Fills state.poses, rvecs and tvecs for every detected marker: the corners of all markers are mapped to
+// normalized coordinates through the calibration's undistortion table and solved together.
+void solvePoses(const CameraCalibration &calibration, double marker_size, FrameState &state);
+
+// Draws the detections and their axes on a bgr8 copy of the frame, rendered into `dst` at the size `dst`
+// already has (a scaled-down overlay keeps its intrinsics and corners consistent). `scratch` is used for
+// resizing.
+void renderOverlay(const cv::Mat &image, const std::string &encoding, const FrameState &state,
+                   const CameraCalibration &calibration, double marker_size, cv::Mat &dst, cv::Mat &scratch);
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__FRAME_PROCESSING_HPP_
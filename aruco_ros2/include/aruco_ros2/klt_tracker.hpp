@@ -0,0 +1,80 @@
+#ifndef ARUCO_ROS2__KLT_TRACKER_HPP_
+#define ARUCO_ROS2__KLT_TRACKER_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/aruco.hpp>
+
+namespace aruco_ros2
+{
+
+struct KltTrackerConfig
+{
+    // Full detection runs on every keyframe_interval-th frame; the frames in between are tracked
+    int keyframe_interval = 6;
+    // Tracked markers are re-decoded in place every verify_interval tracked frames (0 disables)
+    int verify_interval = 3;
+    // Pyramidal Lucas-Kanade settings
+    cv::Size window_size{21, 21};
+    int max_level = 3;
+    // Maximum forward-backward error, in pixels, for a tracked corner to be trusted
+    double max_fb_error = 1.0;
+};
+
+// Propagates the corners of the markers found on a keyframe to the following frames with pyramidal
+// Lucas-Kanade optical flow, so the full detector only runs on keyframes. A marker whose corners cannot
+// be tracked reliably, whose quad degenerates, or whose bits no longer decode to its id is dropped, and
+// the next frame becomes a keyframe. Thread-safe; with several detection workers, frames are tracked
+// from the newest frame that has been processed. The lock only guards taking and committing that
+// reference frame; pyramid construction, optical flow and verification run unlocked, so workers of one
+// camera track concurrently.
+class KltTracker
+{
+public:
+    explicit KltTracker(const KltTrackerConfig &config);
+
+    // Tracks the known markers into frame `seq`. Returns false, without touching the outputs, if the
+    // frame has to be a keyframe (interval elapsed, a track was lost, or nothing is tracked); the caller
+    // then runs the detector and passes the result to keyframe(). Verification decodes the markers with
+    // `dictionary`, the one the frame is being detected with, so that it can change at runtime.
+    bool track(uint64_t seq, const cv::Mat &gray, const cv::Ptr<cv::aruco::Dictionary> &dictionary,
+               int marker_border_bits, std::vector<int> &ids, std::vector<std::vector<cv::Point2f>> &corners);
+
+    // Records the detections of keyframe `seq` as the new set of tracks
+    void keyframe(uint64_t seq, const cv::Mat &gray, const std::vector<int> &ids,
+                  const std::vector<std::vector<cv::Point2f>> &corners);
+
+private:
+    using Pyramid = std::vector<cv::Mat>;
+
+    void buildPyramid(const cv::Mat &gray, Pyramid &pyramid);
+    std::shared_ptr<Pyramid> takeSparePyramid();
+    void recycle(std::shared_ptr<Pyramid> &&pyramid);
+    void commit(uint64_t seq, std::shared_ptr<Pyramid> &&pyramid, std::vector<int> &&ids,
+                std::vector<std::vector<cv::Point2f>> &&corners);
+    static bool verify(const cv::Mat &gray, const std::vector<cv::Point2f> &corners, int id,
+                       const cv::aruco::Dictionary &dictionary, int marker_border_bits);
+    static bool plausible(const std::vector<cv::Point2f> &previous, const std::vector<cv::Point2f> &current);
+
+    KltTrackerConfig config_;
+
+    std::mutex mutex_;
+    // Pyramid of the newest processed frame. Workers tracking from it hold a reference while they run
+    // unlocked, so a retired pyramid is only reused once nobody else holds it.
+    std::shared_ptr<Pyramid> pyramid_;
+    std::shared_ptr<Pyramid> spare_pyramid_; // retired pyramid whose buffers are reused for the next frame
+    std::vector<int> ids_;
+    std::vector<std::vector<cv::Point2f>> corners_;
+    uint64_t seq_ = 0;
+    uint64_t keyframe_seq_ = 0;
+    bool have_keyframe_ = false;
+    bool lost_ = true;
+};
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__KLT_TRACKER_HPP_
@@ -0,0 +1,68 @@
+#ifndef ARUCO_ROS2__MAILBOX_HPP_
+#define ARUCO_ROS2__MAILBOX_HPP_
+
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+namespace aruco_ros2
+{
+
+// Single-slot "latest wins" hand-off between a producer (the image subscription) and one consumer
+// (the detection thread). An item still waiting when a newer one arrives is replaced, so the
+// consumer always works on the most recent frame and never on a backlog.
+template <typename T>
+class Mailbox
+{
+public:
+    // Stores `item`, replacing any pending one. Returns true if a pending item was superseded.
+    bool put(T item)
+    {
+        bool superseded;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            superseded = has_item_;
+            item_ = std::move(item);
+            has_item_ = true;
+        }
+        cv_.notify_one();
+        return superseded;
+    }
+
+    // Blocks until an item is available or the mailbox is closed. Returns false once closed.
+    bool take(T &item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]
+                 { return has_item_ || closed_; });
+        if (closed_)
+        {
+            return false;
+        }
+        item = std::move(item_);
+        item_ = T();
+        has_item_ = false;
+        return true;
+    }
+
+    // Wakes the consumer and makes every further take() fail
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    T item_{};
+    bool has_item_ = false;
+    bool closed_ = false;
+};
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__MAILBOX_HPP_
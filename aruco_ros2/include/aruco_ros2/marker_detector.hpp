@@ -0,0 +1,84 @@
+#ifndef ARUCO_ROS2__MARKER_DETECTOR_HPP_
+#define ARUCO_ROS2__MARKER_DETECTOR_HPP_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "aruco_ros2/camera_calibration.hpp"
+#include "aruco_ros2/frame_processing.hpp"
+#include "aruco_ros2/klt_tracker.hpp"
+#include "aruco_ros2/roi_tracker.hpp"
+
+namespace aruco_ros2
+{
+
+enum class TrackingMode
+{
+    None, // full-frame detection on every frame
+    Roi,  // detect only around where the known markers are expected, with periodic full scans
+    Klt,  // follow the marker corners with optical flow until the next keyframe
+};
+
+// Parses "none", "roi" or "klt". Returns false if unknown.
+bool parseTrackingMode(const std::string &name, TrackingMode &mode);
+
+struct TrackingConfig
+{
+    TrackingMode mode = TrackingMode::None;
+    // Full scan (roi) or keyframe (klt) at least every this many frames
+    int full_scan_interval = 10;
+    // roi: padding around each predicted marker, as a fraction of its bounding box size
+    double roi_padding = 0.5;
+    // klt: tracked markers are re-decoded every this many frames
+    int klt_verify_interval = 3;
+};
+
+// One detected marker: its corners in input-image pixels and, when the pose could be solved, its pose in
+// the camera frame
+struct MarkerDetection
+{
+    int id = 0;
+    std::array<cv::Point2f, 4> corners;
+    bool has_pose = false;
+    cv::Vec3d translation; // meters
+    cv::Vec4d rotation;    // quaternion x, y, z, w
+};
+
+// Marker detection and pose estimation for the frames of one camera, without ROS. The detector only
+// holds the tracking state carried from frame to frame; everything computed for a frame lives in the
+// caller's FrameState, which is meant to be reused so that the steady state doesn't allocate. Frames can
+// be processed concurrently, each with its own FrameState, as long as `seq` numbers them in input order.
+class MarkerDetector
+{
+public:
+    explicit MarkerDetector(const TrackingConfig &tracking = TrackingConfig());
+
+    // Runs the detector on state.gray: on the whole image, only within the regions predicted by the ROI
+    // tracker, or not at all when the KLT tracker can follow the markers into this frame. The detector
+    // settings come from `config`, reduced by the budget controller's `effort_level`. Returns true when
+    // the whole image was scanned.
+    bool detect(uint64_t seq, const DetectorConfig &config, int effort_level, FrameState &state);
+
+    // Conversion, detection and pose estimation of one frame. `image` is a view of the frame, not copied,
+    // in a sensor_msgs encoding (mono8, bgr8, rgb8, bgra8 or rgba8; anything else throws
+    // std::invalid_argument). The results are left in `state` and summarised in `detections`.
+    void process(uint64_t seq, const cv::Mat &image, const std::string &encoding,
+                 const CameraCalibration &calibration, const DetectorConfig &config, FrameState &state,
+                 std::vector<MarkerDetection> &detections);
+
+private:
+    std::unique_ptr<RoiTracker> roi_tracker_;
+    std::unique_ptr<KltTracker> klt_tracker_;
+};
+
+// The markers of a processed frame, with the poses from solvePoses when it ran
+void collectDetections(const FrameState &state, std::vector<MarkerDetection> &detections);
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__MARKER_DETECTOR_HPP_
@@ -0,0 +1,26 @@
+#ifndef ARUCO_ROS2__MARKER_MESSAGES_HPP_
+#define ARUCO_ROS2__MARKER_MESSAGES_HPP_
+
+#include <builtin_interfaces/msg/time.hpp>
+#include <geometry_msgs/msg/transform_stamped.hpp>
+#include <std_msgs/msg/header.hpp>
+#include <aruco_ros2_msgs/msg/marker.hpp>
+#include <aruco_ros2_msgs/msg/marker_array.hpp>
+
+#include "aruco_ros2/frame_processing.hpp"
+
+namespace aruco_ros2
+{
+
+// Appends a Marker for every marker of the frame whose pose was solved, with `header` (the image stamp
+// and the camera frame). Returns the number of markers left out because their pose could not be solved.
+size_t appendMarkers(const FrameState &state, const std_msgs::msg::Header &header,
+                     aruco_ros2_msgs::msg::MarkerArray &array);
+
+// Transform from the marker's camera frame to aruco_marker_<id>
+geometry_msgs::msg::TransformStamped markerTransform(const aruco_ros2_msgs::msg::Marker &marker,
+                                                     const builtin_interfaces::msg::Time &stamp);
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__MARKER_MESSAGES_HPP_
@@ -0,0 +1,84 @@
+#ifndef ARUCO_ROS2__REORDER_BUFFER_HPP_
+#define ARUCO_ROS2__REORDER_BUFFER_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+namespace aruco_ros2
+{
+
+// Restores input order for items that complete out of order (frames detected on a worker pool).
+// Items are released strictly by increasing sequence number. If the next expected item is missing
+// and the oldest item waiting behind it has waited longer than `max_latency`, the gap is skipped.
+// An item that arrives after its slot was skipped is rejected, so output order never goes backwards.
+// Not thread-safe: owned by the single stage that consumes the workers' results.
+template <typename T>
+class ReorderBuffer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ReorderBuffer(Clock::duration max_latency)
+        : max_latency_(max_latency)
+    {
+    }
+
+    // Stores `item` under sequence number `seq`. Returns false, leaving `item` untouched, if that
+    // sequence number has already been released or skipped.
+    bool insert(uint64_t seq, T &&item, Clock::time_point now)
+    {
+        if (seq < next_seq_)
+        {
+            return false;
+        }
+        pending_.emplace(seq, Entry{std::move(item), now});
+        return true;
+    }
+
+    // Releases the next item in order, skipping a gap once it has held up later items for longer than
+    // the maximum latency. Returns false if nothing can be released yet.
+    bool pop(T &item, Clock::time_point now)
+    {
+        if (pending_.empty())
+        {
+            return false;
+        }
+        auto oldest = pending_.begin();
+        if (oldest->first != next_seq_)
+        {
+            if (now - oldest->second.arrival < max_latency_)
+            {
+                return false;
+            }
+            skipped_ += oldest->first - next_seq_;
+            next_seq_ = oldest->first;
+        }
+        item = std::move(oldest->second.item);
+        pending_.erase(oldest);
+        next_seq_++;
+        return true;
+    }
+
+    size_t size() const { return pending_.size(); }
+
+    // Number of sequence numbers given up on because they held up later items for too long
+    uint64_t skipped() const { return skipped_; }
+
+private:
+    struct Entry
+    {
+        T item;
+        Clock::time_point arrival;
+    };
+
+    Clock::duration max_latency_;
+    std::map<uint64_t, Entry> pending_;
+    uint64_t next_seq_ = 0;
+    uint64_t skipped_ = 0;
+};
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__REORDER_BUFFER_HPP_
@@ -0,0 +1,64 @@
+#ifndef ARUCO_ROS2__ROI_TRACKER_HPP_
+#define ARUCO_ROS2__ROI_TRACKER_HPP_
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace aruco_ros2
+{
+
+struct RoiTrackerConfig
+{
+    // A full-frame scan is forced at least every this many frames, to pick up new markers
+    int full_scan_interval = 10;
+    // ROI padding around each predicted marker, as a fraction of the marker's bounding box size
+    double padding = 0.5;
+    // Lower bound for the padding, in pixels, so small or distant markers still get some search area
+    int min_padding_px = 16;
+};
+
+// Keeps the markers found in the most recent frame and predicts where they will be in the next one,
+// so detection can be restricted to a few padded regions instead of the whole image. Shared by the
+// detection workers, so all methods are thread-safe; with several workers, predictions come from the
+// newest frame that has finished detection.
+class RoiTracker
+{
+public:
+    explicit RoiTracker(const RoiTrackerConfig &config);
+
+    // Decides how frame `seq` should be scanned. Returns true and fills `rois` (non-overlapping, clipped
+    // to the image) if a ROI scan is enough; returns false if the frame needs a full-frame scan because
+    // the interval elapsed, a track was lost, or nothing is being tracked.
+    bool predict(uint64_t seq, const cv::Size &image_size, std::vector<cv::Rect> &rois);
+
+    // Records the detections of frame `seq`. Results older than the newest recorded frame are ignored.
+    void update(uint64_t seq, bool full_scan, const std::vector<int> &ids,
+                const std::vector<std::vector<cv::Point2f>> &corners);
+
+private:
+    struct Track
+    {
+        int id;
+        std::vector<cv::Point2f> corners;
+        cv::Point2f velocity; // centroid motion per frame
+    };
+
+    static cv::Point2f centroid(const std::vector<cv::Point2f> &corners);
+    static void mergeOverlapping(std::vector<cv::Rect> &rois);
+
+    RoiTrackerConfig config_;
+    std::mutex mutex_;
+    std::vector<Track> tracks_;
+    uint64_t last_seq_ = 0;
+    bool have_update_ = false;
+    uint64_t last_full_scan_seq_ = 0;
+    bool have_full_scan_ = false;
+    bool lost_ = true;
+};
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__ROI_TRACKER_HPP_
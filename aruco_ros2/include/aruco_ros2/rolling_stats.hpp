@@ -0,0 +1,77 @@
+#ifndef ARUCO_ROS2__ROLLING_STATS_HPP_
+#define ARUCO_ROS2__ROLLING_STATS_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace aruco_ros2
+{
+
+// Distribution of the last `capacity` samples of one quantity (a stage time, a count). Adding a sample
+// never allocates; percentiles are computed on demand from a copy, off the hot path. Not thread-safe.
+class RollingStats
+{
+public:
+    struct Summary
+    {
+        size_t count = 0; // samples in the window
+        double mean = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    explicit RollingStats(size_t capacity = 1024) : samples_(capacity) {}
+
+    void add(double value)
+    {
+        samples_[next_] = value;
+        next_ = (next_ + 1) % samples_.size();
+        size_ = std::min(size_ + 1, samples_.size());
+        ++total_;
+    }
+
+    // Samples ever added, including those that have left the window
+    uint64_t total() const { return total_; }
+
+    // `scratch` is reused between calls to avoid allocating
+    Summary summary(std::vector<double> &scratch) const
+    {
+        Summary result;
+        result.count = size_;
+        if (size_ == 0)
+        {
+            return result;
+        }
+        scratch.assign(samples_.begin(), samples_.begin() + size_);
+        std::sort(scratch.begin(), scratch.end());
+        double sum = 0.0;
+        for (double value : scratch)
+        {
+            sum += value;
+        }
+        const auto at = [&scratch](double q)
+        {
+            return scratch[std::min(scratch.size() - 1, static_cast<size_t>(q * scratch.size()))];
+        };
+        result.mean = sum / scratch.size();
+        result.p50 = at(0.50);
+        result.p95 = at(0.95);
+        result.p99 = at(0.99);
+        result.max = scratch.back();
+        return result;
+    }
+
+private:
+    std::vector<double> samples_;
+    size_t next_ = 0;
+    size_t size_ = 0;
+    uint64_t total_ = 0;
+};
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__ROLLING_STATS_HPP_
@@ -0,0 +1,61 @@
+#ifndef ARUCO_ROS2__SNAPSHOT_HPP_
+#define ARUCO_ROS2__SNAPSHOT_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace aruco_ros2
+{
+
+// Hands immutable snapshots of T from a writer (e.g. a parameter callback) to reader threads. Each
+// reader keeps its own Reader, which caches the last snapshot it saw and only reloads the shared pointer
+// after the version counter shows a newer one was published. A read is therefore one atomic load in
+// steady state, and a reader that holds a snapshot keeps it alive however often it is replaced. The
+// shared-pointer atomics are not lock-free: libstdc++ implements them with a small pool of global
+// mutexes, so publish() and the first read after it take a briefly held lock. That happens once per
+// reconfiguration, never per frame.
+template <typename T>
+class Snapshot
+{
+public:
+    class Reader
+    {
+    public:
+        explicit Reader(const Snapshot &source) : source_(source) {}
+
+        // Returns the newest published snapshot (null before the first publish)
+        const std::shared_ptr<const T> &get()
+        {
+            const uint64_t version = source_.version_.load(std::memory_order_acquire);
+            if (version != seen_version_)
+            {
+                value_ = std::atomic_load(&source_.value_);
+                seen_version_ = version;
+            }
+            return value_;
+        }
+
+    private:
+        const Snapshot &source_;
+        uint64_t seen_version_ = 0;
+        std::shared_ptr<const T> value_;
+    };
+
+    void publish(std::shared_ptr<const T> value)
+    {
+        std::atomic_store(&value_, std::move(value));
+        version_.fetch_add(1, std::memory_order_release);
+    }
+
+    // Read without a Reader, for code outside the hot path
+    std::shared_ptr<const T> load() const { return std::atomic_load(&value_); }
+
+private:
+    std::shared_ptr<const T> value_;
+    std::atomic<uint64_t> version_{0};
+};
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__SNAPSHOT_HPP_
@@ -0,0 +1,167 @@
+#ifndef ARUCO_ROS2__SPSC_QUEUE_HPP_
+#define ARUCO_ROS2__SPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace aruco_ros2
+{
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread. Used for the
+// hand-off between pipeline stages. Head and tail live on separate cache lines, and each side keeps a
+// cached copy of the other side's index so the shared line is only read when the cache says the queue
+// looks full (producer) or empty (consumer).
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t capacity)
+        : capacity_(roundUpPow2(capacity)), mask_(capacity_ - 1), slots_(capacity_)
+    {
+    }
+
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer side. On failure (queue full) `item` is left untouched.
+    bool try_push(T &&item)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ == capacity_)
+        {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ == capacity_)
+            {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool try_pop(T &item)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_cache_)
+        {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (head == tail_cache_)
+            {
+                return false;
+            }
+        }
+        item = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: true if a try_pop() now would fail
+    bool empty() const { return head_.load(std::memory_order_relaxed) == tail_.load(std::memory_order_acquire); }
+
+    size_t capacity() const { return capacity_; }
+
+private:
+    static size_t roundUpPow2(size_t n)
+    {
+        size_t p = 1;
+        while (p < n)
+        {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    static constexpr size_t kCacheLine = 64;
+
+    const size_t capacity_;
+    const size_t mask_;
+    std::vector<T> slots_;
+
+    // Consumer-owned
+    alignas(kCacheLine) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+
+    // Producer-owned
+    alignas(kCacheLine) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+};
+
+// Idle strategy for pipeline threads waiting on an SpscQueue: spin briefly with yields, then fall back
+// to short sleeps so an idle pipeline does not burn a core. Threads that can block on an EventCount use
+// spin() for the hot window and block once it returns false.
+class Backoff
+{
+public:
+    // Yields and returns true during the spin window; returns false, without yielding, after it
+    bool spin()
+    {
+        if (spins_ < kYieldSpins)
+        {
+            ++spins_;
+            std::this_thread::yield();
+            return true;
+        }
+        return false;
+    }
+
+    void idle()
+    {
+        if (spins_ < kYieldSpins)
+        {
+            ++spins_;
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+
+    void reset() { spins_ = 0; }
+
+private:
+    static constexpr int kYieldSpins = 64;
+    int spins_ = 0;
+};
+
+// Pushes `item`, waiting while the queue is full. Returns false if `running` drops first.
+template <typename T>
+bool push_wait(SpscQueue<T> &queue, T &&item, const std::atomic<bool> &running)
+{
+    Backoff backoff;
+    while (!queue.try_push(std::move(item)))
+    {
+        if (!running.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        backoff.idle();
+    }
+    return true;
+}
+
+// Pops into `item`, waiting while the queue is empty. Returns false if `running` drops first.
+template <typename T>
+bool pop_wait(SpscQueue<T> &queue, T &item, const std::atomic<bool> &running)
+{
+    Backoff backoff;
+    while (!queue.try_pop(item))
+    {
+        if (!running.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        backoff.idle();
+    }
+    return true;
+}
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__SPSC_QUEUE_HPP_
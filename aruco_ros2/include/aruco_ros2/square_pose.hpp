@@ -0,0 +1,51 @@
+#ifndef ARUCO_ROS2__SQUARE_POSE_HPP_
+#define ARUCO_ROS2__SQUARE_POSE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace aruco_ros2
+{
+
+// Structure-of-arrays batch for the square-marker pose solver. Marker i's corners (in the detector's
+// order: top-left, top-right, bottom-right, bottom-left) are given in normalized, undistorted image
+// coordinates as (u[k][i], v[k][i]). The solver fills the translation, the rotation as a unit
+// quaternion, and the RMS reprojection error in normalized units. All vectors are reused across frames,
+// so a steady scene does not allocate.
+struct SquarePoseBatch
+{
+    std::array<std::vector<double>, 4> u;
+    std::array<std::vector<double>, 4> v;
+
+    std::vector<double> tx, ty, tz;
+    std::vector<double> qx, qy, qz, qw;
+    std::vector<double> error;
+    std::vector<unsigned char> valid;
+
+    void resize(size_t n);
+    size_t size() const { return tx.size(); }
+
+    // Per-marker intermediates of the solver (homography, both IPPE rotations and translations, and the
+    // validity of the kept solution as 1.0 or 0.0 before it is narrowed into `valid`)
+    std::array<std::vector<double>, 9> h;
+    std::array<std::vector<double>, 9> r1, r2;
+    std::array<std::vector<double>, 3> t1, t2;
+    std::vector<double> e1, e2;
+    std::vector<double> keep;
+};
+
+// Solves the poses of all markers in `batch` with the closed-form IPPE method (Collins & Bartoli,
+// "Infinitesimal Plane-based Pose Estimation", IJCV 2014) specialised to a square of side `marker_size`
+// centred on the marker origin, as cv::aruco::estimatePoseSingleMarkers models it. Of the two IPPE
+// solutions, the one with the lower reprojection error is kept. The per-stage loops run over the
+// structure-of-arrays layout without branches so the compiler can vectorize them across markers.
+void solveSquarePoses(SquarePoseBatch &batch, double marker_size);
+
+// Converts a unit quaternion to an axis-angle rotation vector (as used by cv::Rodrigues), for the few
+// consumers (overlay drawing) that still need one
+void quaternionToRotationVector(double qx, double qy, double qz, double qw, double rvec[3]);
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__SQUARE_POSE_HPP_
@@ -0,0 +1,93 @@
+#ifndef ARUCO_ROS2__SYNTHETIC_SCENE_HPP_
+#define ARUCO_ROS2__SYNTHETIC_SCENE_HPP_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <opencv2/aruco.hpp>
+#include <opencv2/core.hpp>
+
+#include "aruco_ros2/camera_calibration.hpp"
+
+namespace aruco_ros2
+{
+
+struct SceneConfig
+{
+    cv::Size image_size{640, 480};
+    std::string dictionary_name = "DICT_ARUCO_ORIGINAL";
+    int marker_count = 1; // distinct ids, at most the dictionary size
+    double marker_size = 0.1; // meters
+    int marker_border_bits = 1;
+    // Markers are laid out on a grid with one marker per cell; each covers about this fraction of its
+    // cell, which sets its distance from the camera
+    double fill = 0.6;
+    double max_tilt_deg = 45.0; // angle between the marker normal and the line of sight
+    double blur_sigma = 0.0;    // Gaussian blur, pixels
+    double noise_sigma = 0.0;   // additive Gaussian noise, gray levels
+    double lighting = 0.0;      // brightness falls off by up to this fraction across the image (0..1)
+    int clutter = 0;            // random distractor shapes behind the markers, including dark squares
+    bool color = true;          // bgr8, or mono8 when false
+    uint64_t seed = 1;
+};
+
+// Ground truth of one rendered marker: the pose of its centre in the camera frame (as solvePoses and
+// cv::aruco::estimatePoseSingleMarkers report it) and its corners in the detector's order
+struct SceneMarker
+{
+    int id = 0;
+    cv::Vec3d translation; // meters
+    cv::Vec4d rotation;    // quaternion x, y, z, w
+    std::array<cv::Point2f, 4> corners;
+};
+
+// Renders synthetic frames of markers at known poses, projected through a camera model, with optional
+// blur, noise, a lighting gradient and clutter. The output only depends on the config (including the
+// seed), so a corpus can be regenerated anywhere instead of being stored. Within a marker the image is
+// warped with the homography of its corners, so lens distortion is only modelled at the corners.
+class SceneGenerator
+{
+public:
+    // Throws std::invalid_argument for an unknown dictionary or more markers than it has ids
+    SceneGenerator(const SceneConfig &config, std::shared_ptr<const CameraCalibration> calibration);
+
+    // Renders the next frame into `image` and replaces `markers` with the markers visible in it. A marker
+    // whose cell is too small to hold it is left out.
+    void render(cv::Mat &image, std::vector<SceneMarker> &markers);
+
+    const SceneConfig &config() const { return config_; }
+    const CameraCalibration &calibration() const { return *calibration_; }
+
+private:
+    void drawClutter(cv::Mat &gray);
+    bool placeMarker(int id, const cv::Rect &cell, cv::Mat &gray, SceneMarker &marker);
+    void applyLighting(cv::Mat &gray);
+
+    SceneConfig config_;
+    std::shared_ptr<const CameraCalibration> calibration_;
+    cv::Ptr<cv::aruco::Dictionary> dictionary_;
+    cv::RNG rng_;
+    std::vector<int> ids_, cells_;
+    cv::Mat gray_, bitmap_, patch_, mask_, noise_;
+};
+
+// Camera with a focal length of one image width and the principal point in the centre: an ideal pinhole,
+// or a distorted or fisheye lens when `distortion` holds coefficients of `model` (as CameraInfo's D)
+std::shared_ptr<const CameraCalibration> makePinholeCalibration(const cv::Size &image_size,
+                                                                const cv::Mat &distortion = cv::Mat(),
+                                                                DistortionModel model = DistortionModel::PlumbBob);
+
+// Parses vga, hd, fhd, 4k, 8k or WIDTHxHEIGHT. Returns false if invalid.
+bool parseResolution(const std::string &text, cv::Size &size);
+
+// ground_truth.csv: one row per marker with the image name, id, pose and corners
+void writeGroundTruthHeader(std::ostream &out);
+void writeGroundTruth(std::ostream &out, const std::string &image_name, const std::vector<SceneMarker> &markers);
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__SYNTHETIC_SCENE_HPP_
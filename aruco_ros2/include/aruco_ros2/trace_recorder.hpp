@@ -0,0 +1,81 @@
+#ifndef ARUCO_ROS2__TRACE_RECORDER_HPP_
+#define ARUCO_ROS2__TRACE_RECORDER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace aruco_ros2
+{
+
+// One pipeline stage of one frame
+struct TraceSpan
+{
+    const char *name = nullptr; // must outlive the recorder (a string literal)
+    uint32_t camera = 0;
+    uint32_t thread = 0;
+    int64_t start_ns = 0; // since the recorder was created
+    int64_t duration_ns = 0;
+    int64_t stamp_ns = 0; // header stamp of the frame
+    uint64_t frame = 0;
+    uint32_t markers = 0;
+};
+
+// In-memory ring of the most recent spans, written from any number of pipeline threads without locks and
+// dumped as a Chrome trace (chrome://tracing, ui.perfetto.dev). When the ring is full the oldest spans are
+// overwritten. Each slot is guarded by a sequence number, so a dump taken while threads are recording
+// skips the slots being written instead of reading torn spans.
+class TraceRecorder
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TraceRecorder(size_t capacity);
+
+    TraceRecorder(const TraceRecorder &) = delete;
+    TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+    void record(const char *name, size_t camera, Clock::time_point start, Clock::time_point end,
+                int64_t stamp_ns, uint64_t frame, size_t markers);
+
+    // Names the calling thread in the trace. Called once per thread, not on the hot path.
+    void nameThread(const std::string &name);
+
+    // Spans currently in the ring, oldest first
+    std::vector<TraceSpan> spans() const;
+
+    // Spans ever recorded, including overwritten ones
+    uint64_t recorded() const { return next_.load(std::memory_order_relaxed); }
+
+    // Writes the ring as Chrome trace JSON. Cameras appear as processes named after `camera_names`, stage
+    // threads as their threads. Returns the number of spans written, or -1 if the file can't be written.
+    long writeChromeTrace(const std::string &path, const std::vector<std::string> &camera_names) const;
+
+private:
+    struct alignas(64) Slot
+    {
+        // 0: never written, odd: being written, otherwise 2 * (index + 1) of the span it holds
+        std::atomic<uint64_t> sequence{0};
+        TraceSpan span;
+    };
+
+    static uint32_t threadId();
+
+    const size_t capacity_;
+    const size_t mask_;
+    const Clock::time_point epoch_;
+    std::vector<Slot> slots_;
+    alignas(64) std::atomic<uint64_t> next_{0};
+
+    mutable std::mutex names_mutex_;
+    std::map<uint32_t, std::string> thread_names_;
+};
+
+} // namespace aruco_ros2
+
+#endif // ARUCO_ROS2__TRACE_RECORDER_HPP_
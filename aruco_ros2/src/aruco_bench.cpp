@@ -0,0 +1,672 @@
+// Offline benchmark: replays a directory of images through the node's per-frame processing (conversion,
+// detection with the node's tracking modes and frame-time budget, pose, overlay), without ROS transport,
+// and reports the time spent in each stage, the frame
+// rate, the marker recall and pose error against ground_truth.csv (when the directory has one) and the
+// peak RSS.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/opencv.hpp>
+#include <camera_calibration_parsers/parse.hpp>
+#include <sensor_msgs/msg/camera_info.hpp>
+
+#include "aruco_ros2/budget_controller.hpp"
+#include "aruco_ros2/camera_calibration.hpp"
+#include "aruco_ros2/detector_parameters.hpp"
+#include "aruco_ros2/frame_processing.hpp"
+#include "aruco_ros2/marker_detector.hpp"
+#include "aruco_ros2/rolling_stats.hpp"
+#include "aruco_ros2/synthetic_scene.hpp"
+
+namespace fs = std::filesystem;
+using namespace aruco_ros2;
+
+namespace
+{
+
+struct Options
+{
+    std::string image_dir;
+    std::string dictionary = "DICT_ARUCO_ORIGINAL";
+    double marker_size = 0.1;
+    std::string preset = "default";
+    std::vector<std::string> detector_overrides; // name=value
+    int pyramid_level = 0;
+    std::string tracking = "none";
+    int full_scan_interval = 10;
+    double target_frame_time_ms = 0.0; // 0 disables the budget controller
+    std::string calibration_file;
+    int repeat = 1;
+    double overlay_scale = 1.0; // 0 skips the overlay
+    std::string format = "json";
+    std::string output; // stdout when empty
+    std::string label;
+};
+
+// A marker expected in an image, with its pose when ground_truth.csv has one
+struct ExpectedMarker
+{
+    bool has_pose = false;
+    cv::Vec3d translation;
+    cv::Vec4d rotation; // quaternion x, y, z, w
+};
+using GroundTruth = std::map<std::string, std::map<int, ExpectedMarker>>;
+
+struct Frame
+{
+    std::string name;
+    cv::Mat image;
+    std::string encoding;
+};
+
+// Stage timings of the whole run, in milliseconds
+struct StageStats
+{
+    explicit StageStats(size_t frames)
+        : conversion(frames), detection(frames), pose(frames), overlay(frames), total(frames)
+    {
+    }
+
+    RollingStats conversion, detection, pose, overlay, total;
+};
+
+void printUsage()
+{
+    std::cerr << "Usage: aruco_bench <image_dir> [options]\n"
+                 "  --dictionary NAME        aruco dictionary (default DICT_ARUCO_ORIGINAL)\n"
+                 "  --marker-size M          marker side in meters (default 0.1)\n"
+                 "  --preset NAME            detector preset: default, fast, balanced, accurate\n"
+                 "  --detector NAME=VALUE    override one DetectorParameters field (repeatable)\n"
+                 "  --pyramid-level N        coarse-to-fine detection level (default 0)\n"
+                 "  --tracking none|roi|klt  tracking mode, as the node's `tracking` parameter (default none)\n"
+                 "  --full-scan-interval N   full scan / keyframe at least every N frames (default 10)\n"
+                 "  --target-frame-time MS   detection time budget per frame, 0 to disable (default 0)\n"
+                 "  --calibration FILE       camera calibration (yaml/ini); default: pinhole, f = width\n"
+                 "  --repeat N               replay the corpus N times (default 1)\n"
+                 "  --overlay-scale S        overlay scale, 0 to skip the overlay (default 1)\n"
+                 "  --format json|csv        report format (default json)\n"
+                 "  --output FILE            write the report to FILE (csv rows are appended)\n"
+                 "  --label TEXT             label of this run in the report\n";
+}
+
+bool parseOptions(int argc, char **argv, Options &options)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        const std::string &arg = args[i];
+        const auto value = [&]() -> const std::string &
+        {
+            if (i + 1 >= args.size())
+            {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return args[++i];
+        };
+        if (arg == "--help" || arg == "-h")
+        {
+            return false;
+        }
+        else if (arg == "--dictionary")
+        {
+            options.dictionary = value();
+        }
+        else if (arg == "--marker-size")
+        {
+            options.marker_size = std::stod(value());
+        }
+        else if (arg == "--preset")
+        {
+            options.preset = value();
+        }
+        else if (arg == "--detector")
+        {
+            options.detector_overrides.push_back(value());
+        }
+        else if (arg == "--pyramid-level")
+        {
+            options.pyramid_level = std::clamp(std::stoi(value()), 0, 4);
+        }
+        else if (arg == "--tracking")
+        {
+            options.tracking = value();
+        }
+        else if (arg == "--full-scan-interval")
+        {
+            options.full_scan_interval = std::max(1, std::stoi(value()));
+        }
+        else if (arg == "--target-frame-time")
+        {
+            options.target_frame_time_ms = std::max(0.0, std::stod(value()));
+        }
+        else if (arg == "--calibration")
+        {
+            options.calibration_file = value();
+        }
+        else if (arg == "--repeat")
+        {
+            options.repeat = std::max(1, std::stoi(value()));
+        }
+        else if (arg == "--overlay-scale")
+        {
+            options.overlay_scale = std::clamp(std::stod(value()), 0.0, 1.0);
+        }
+        else if (arg == "--format")
+        {
+            options.format = value();
+            if (options.format != "json" && options.format != "csv")
+            {
+                throw std::invalid_argument("format must be json or csv");
+            }
+        }
+        else if (arg == "--output")
+        {
+            options.output = value();
+        }
+        else if (arg == "--label")
+        {
+            options.label = value();
+        }
+        else if (!arg.empty() && arg[0] != '-' && options.image_dir.empty())
+        {
+            options.image_dir = arg;
+        }
+        else
+        {
+            throw std::invalid_argument("unknown argument " + arg);
+        }
+    }
+    return !options.image_dir.empty();
+}
+
+void applyDetectorOverride(const std::string &assignment, cv::aruco::DetectorParameters &params)
+{
+    const size_t equals = assignment.find('=');
+    if (equals == std::string::npos)
+    {
+        throw std::invalid_argument("--detector expects NAME=VALUE, got " + assignment);
+    }
+    const std::string field_name = assignment.substr(0, equals);
+    const std::string text = assignment.substr(equals + 1);
+    bool found = false;
+    visitDetectorParameters(params, [&](const char *name, auto &field)
+    {
+        using T = std::decay_t<decltype(field)>;
+        if (found || field_name != name)
+        {
+            return;
+        }
+        found = true;
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            field = text == "true" || text == "1";
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            field = static_cast<T>(std::stol(text));
+        }
+        else
+        {
+            field = static_cast<T>(std::stod(text));
+        }
+    });
+    if (!found)
+    {
+        throw std::invalid_argument("unknown detector parameter " + field_name);
+    }
+}
+
+// Every image in the directory, decoded up front so that disk and decoding time are not measured
+std::vector<Frame> loadImages(const std::string &dir)
+{
+    static const std::set<std::string> extensions{".png", ".jpg", ".jpeg", ".bmp", ".pgm", ".ppm", ".tif", ".tiff"};
+    std::vector<fs::path> paths;
+    for (const auto &entry : fs::directory_iterator(dir))
+    {
+        std::string extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (entry.is_regular_file() && extensions.count(extension))
+        {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<Frame> frames;
+    for (const auto &path : paths)
+    {
+        Frame frame;
+        frame.name = path.filename().string();
+        frame.image = cv::imread(path.string(), cv::IMREAD_UNCHANGED);
+        if (frame.image.empty() || frame.image.depth() != CV_8U)
+        {
+            std::cerr << "Skipping " << frame.name << ": not an 8-bit image\n";
+            continue;
+        }
+        frame.encoding = frame.image.channels() == 1 ? "mono8" : frame.image.channels() == 4 ? "bgra8" : "bgr8";
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+// ground_truth.csv: a header line naming at least the `image` and `id` columns, then one row per marker
+// visible in an image. With tx, ty, tz, qx, qy, qz and qw columns (as aruco_scene_gen writes them) the
+// pose error is measured too. Other columns are ignored.
+GroundTruth loadGroundTruth(const fs::path &path)
+{
+    GroundTruth truth;
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line))
+    {
+        return truth;
+    }
+    const auto split = [](const std::string &text)
+    {
+        std::vector<std::string> cells;
+        std::stringstream stream(text);
+        std::string cell;
+        while (std::getline(stream, cell, ','))
+        {
+            cells.push_back(cell);
+        }
+        return cells;
+    };
+    const std::vector<std::string> header = split(line);
+    const auto column = [&header](const char *name)
+    {
+        const auto it = std::find(header.begin(), header.end(), name);
+        return it == header.end() ? -1 : static_cast<int>(it - header.begin());
+    };
+    const int image_column = column("image");
+    const int id_column = column("id");
+    if (image_column < 0 || id_column < 0)
+    {
+        throw std::invalid_argument(path.string() + " needs image and id columns");
+    }
+    const std::vector<int> pose_columns{column("tx"), column("ty"), column("tz"), column("qx"),
+                                        column("qy"), column("qz"), column("qw")};
+    const bool have_pose = *std::min_element(pose_columns.begin(), pose_columns.end()) >= 0;
+    const int last_column = std::max(std::max(image_column, id_column),
+                                     *std::max_element(pose_columns.begin(), pose_columns.end()));
+
+    while (std::getline(in, line))
+    {
+        const std::vector<std::string> cells = split(line);
+        if (cells.size() <= static_cast<size_t>(std::max(image_column, id_column)))
+        {
+            continue;
+        }
+        ExpectedMarker &marker = truth[cells[image_column]][std::stoi(cells[id_column])];
+        if (have_pose && cells.size() > static_cast<size_t>(last_column))
+        {
+            marker.has_pose = true;
+            marker.translation = cv::Vec3d(std::stod(cells[pose_columns[0]]), std::stod(cells[pose_columns[1]]),
+                                           std::stod(cells[pose_columns[2]]));
+            marker.rotation = cv::Vec4d(std::stod(cells[pose_columns[3]]), std::stod(cells[pose_columns[4]]),
+                                        std::stod(cells[pose_columns[5]]), std::stod(cells[pose_columns[6]]));
+        }
+    }
+    return truth;
+}
+
+std::shared_ptr<const CameraCalibration> loadCalibration(const std::string &file)
+{
+    sensor_msgs::msg::CameraInfo info;
+    std::string camera_name;
+    if (!camera_calibration_parsers::readCalibration(file, camera_name, info))
+    {
+        throw std::invalid_argument("Could not read calibration file: " + file);
+    }
+    DistortionModel model;
+    if (!parseDistortionModel(info.distortion_model, model))
+    {
+        throw std::invalid_argument("Unsupported distortion model: " + info.distortion_model);
+    }
+    const cv::Mat camera_matrix = cv::Mat(3, 3, CV_64F, info.k.data()).clone();
+    const cv::Mat distortion = info.d.empty() ? cv::Mat() : cv::Mat(1, static_cast<int>(info.d.size()), CV_64F, info.d.data()).clone();
+    return std::make_shared<const CameraCalibration>(cv::Size(info.width, info.height), camera_matrix, distortion, model);
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// A JSON string literal, quoted and escaped
+std::string jsonString(const std::string &text)
+{
+    std::string quoted = "\"";
+    for (const char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            quoted += "\\\"";
+            break;
+        case '\\':
+            quoted += "\\\\";
+            break;
+        case '\n':
+            quoted += "\\n";
+            break;
+        case '\r':
+            quoted += "\\r";
+            break;
+        case '\t':
+            quoted += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                quoted += escaped;
+            }
+            else
+            {
+                quoted += c;
+            }
+        }
+    }
+    return quoted + "\"";
+}
+
+long peakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    Options options;
+    try
+    {
+        if (!parseOptions(argc, argv, options))
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "aruco_bench: " << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    try
+    {
+        DetectorConfig config;
+        config.dictionary_name = options.dictionary;
+        config.dictionary = cv::aruco::getPredefinedDictionary(dictNameToEnum(options.dictionary));
+        config.marker_size = options.marker_size;
+        config.pyramid_level = options.pyramid_level;
+        config.parameters = cv::makePtr<cv::aruco::DetectorParameters>();
+        if (!applyDetectorPreset(options.preset, *config.parameters))
+        {
+            throw std::invalid_argument("unknown preset " + options.preset);
+        }
+        for (const std::string &assignment : options.detector_overrides)
+        {
+            applyDetectorOverride(assignment, *config.parameters);
+        }
+        std::string error;
+        if (!validateDetectorParameters(*config.parameters, error))
+        {
+            throw std::invalid_argument(error);
+        }
+        TrackingConfig tracking;
+        if (!parseTrackingMode(options.tracking, tracking.mode))
+        {
+            throw std::invalid_argument("unknown tracking mode " + options.tracking);
+        }
+        tracking.full_scan_interval = options.full_scan_interval;
+
+        const std::vector<Frame> frames = loadImages(options.image_dir);
+        if (frames.empty())
+        {
+            throw std::invalid_argument("no images in " + options.image_dir);
+        }
+        const fs::path truth_path = fs::path(options.image_dir) / "ground_truth.csv";
+        const bool have_truth = fs::exists(truth_path);
+        const GroundTruth truth = have_truth ? loadGroundTruth(truth_path) : GroundTruth();
+
+        std::shared_ptr<const CameraCalibration> calibration;
+        if (!options.calibration_file.empty())
+        {
+            calibration = loadCalibration(options.calibration_file);
+        }
+
+        // Detection state carried between frames, as in one camera of the node
+        MarkerDetector detector(tracking);
+        std::unique_ptr<BudgetController> budget;
+        if (options.target_frame_time_ms > 0.0)
+        {
+            BudgetControllerConfig budget_config;
+            budget_config.target_ms = options.target_frame_time_ms;
+            budget = std::make_unique<BudgetController>(budget_config);
+        }
+        // As in the node: frames_seen counts every input frame for the stride, seq only the processed ones
+        uint64_t seq = 0, frames_seen = 0, frames_skipped = 0;
+
+        const size_t total_frames = frames.size() * options.repeat;
+        StageStats stats(total_frames);
+        FrameState state;
+        cv::Mat overlay, overlay_scratch;
+        uint64_t markers_detected = 0, markers_expected = 0, markers_found = 0, false_positives = 0;
+        // Pose error of the correctly detected markers: distance in meters, rotation angle in degrees
+        uint64_t poses_compared = 0;
+        double translation_error_sum = 0.0, rotation_error_sum = 0.0;
+
+        const auto run_start = std::chrono::steady_clock::now();
+        for (int pass = 0; pass < options.repeat; ++pass)
+        {
+            for (const Frame &frame : frames)
+            {
+                if (!calibration || calibration->imageSize() != frame.image.size())
+                {
+                    if (!options.calibration_file.empty())
+                    {
+                        throw std::invalid_argument(frame.name + " does not match the calibration's resolution");
+                    }
+                    calibration = makePinholeCalibration(frame.image.size());
+                }
+
+                // Over budget even at reduced effort, the node only processes every n-th frame
+                const int effort_level = budget ? budget->level() : 0;
+                if (frames_seen++ % frameStride(effort_level) != 0)
+                {
+                    ++frames_skipped;
+                    continue;
+                }
+
+                const auto t0 = std::chrono::steady_clock::now();
+                convertToGray(frame.image, frame.encoding, state);
+                const auto t1 = std::chrono::steady_clock::now();
+                detector.detect(seq++, config, effort_level, state);
+                const auto t2 = std::chrono::steady_clock::now();
+                if (budget)
+                {
+                    budget->addSample(elapsedMs(t1, t2) / frameStride(effort_level));
+                }
+                if (!state.marker_ids.empty())
+                {
+                    solvePoses(*calibration, config.marker_size, state);
+                }
+                else
+                {
+                    state.rvecs.clear();
+                    state.tvecs.clear();
+                    state.poses.resize(0);
+                }
+                const auto t3 = std::chrono::steady_clock::now();
+                if (options.overlay_scale > 0.0)
+                {
+                    const cv::Size size(std::max(1, static_cast<int>(std::lround(frame.image.cols * options.overlay_scale))),
+                                        std::max(1, static_cast<int>(std::lround(frame.image.rows * options.overlay_scale))));
+                    overlay.create(size, CV_8UC3);
+                    renderOverlay(frame.image, frame.encoding, state, *calibration, config.marker_size, overlay, overlay_scratch);
+                }
+                const auto t4 = std::chrono::steady_clock::now();
+
+                stats.conversion.add(elapsedMs(t0, t1));
+                stats.detection.add(elapsedMs(t1, t2));
+                stats.pose.add(elapsedMs(t2, t3));
+                stats.overlay.add(elapsedMs(t3, t4));
+                stats.total.add(elapsedMs(t0, t4));
+
+                markers_detected += state.marker_ids.size();
+                if (have_truth)
+                {
+                    const auto expected = truth.find(frame.name);
+                    const std::set<int> detected(state.marker_ids.begin(), state.marker_ids.end());
+                    const size_t expected_count = expected == truth.end() ? 0 : expected->second.size();
+                    size_t found = 0;
+                    for (int id : detected)
+                    {
+                        if (expected != truth.end() && expected->second.count(id))
+                        {
+                            ++found;
+                        }
+                    }
+                    for (size_t i = 0; expected != truth.end() && i < state.marker_ids.size(); ++i)
+                    {
+                        const auto marker = expected->second.find(state.marker_ids[i]);
+                        if (marker == expected->second.end() || !marker->second.has_pose || !state.poses.valid[i])
+                        {
+                            continue;
+                        }
+                        const SquarePoseBatch &poses = state.poses;
+                        const cv::Vec4d q(poses.qx[i], poses.qy[i], poses.qz[i], poses.qw[i]);
+                        translation_error_sum += cv::norm(cv::Vec3d(poses.tx[i], poses.ty[i], poses.tz[i]) - marker->second.translation);
+                        rotation_error_sum += 2.0 * std::acos(std::min(1.0, std::abs(q.dot(marker->second.rotation)))) * 180.0 / CV_PI;
+                        ++poses_compared;
+                    }
+                    markers_expected += expected_count;
+                    markers_found += found;
+                    false_positives += detected.size() - found;
+                }
+            }
+        }
+        const double run_s = elapsedMs(run_start, std::chrono::steady_clock::now()) / 1000.0;
+
+        const double fps = total_frames / run_s;
+        const int final_effort_level = budget ? budget->level() : 0;
+        const double recall = markers_expected > 0 ? static_cast<double>(markers_found) / markers_expected : -1.0;
+        const double translation_error = poses_compared > 0 ? translation_error_sum / poses_compared : 0.0;
+        const double rotation_error = poses_compared > 0 ? rotation_error_sum / poses_compared : 0.0;
+        const long rss_kb = peakRssKb();
+        std::vector<double> scratch;
+        const std::vector<std::pair<const char *, const RollingStats *>> stages{
+            {"conversion", &stats.conversion}, {"detection", &stats.detection}, {"pose", &stats.pose},
+            {"overlay", &stats.overlay}, {"total", &stats.total}};
+
+        // CSV reports are appended to, so runs with different settings end up in one table
+        const bool csv_header = options.output.empty() || !fs::exists(options.output);
+        std::ofstream file;
+        if (!options.output.empty())
+        {
+            file.open(options.output, options.format == "csv" ? std::ios::app : std::ios::trunc);
+            if (!file)
+            {
+                throw std::invalid_argument("could not open " + options.output);
+            }
+        }
+        std::ostream &out = options.output.empty() ? std::cout : file;
+
+        char number[32];
+        const auto fmt = [&number](double value)
+        {
+            std::snprintf(number, sizeof(number), "%.4f", value);
+            return std::string(number);
+        };
+        if (options.format == "json")
+        {
+            out << "{\n  \"label\": " << jsonString(options.label) << ",\n  \"image_dir\": "
+                << jsonString(options.image_dir) << ",\n  \"images\": " << frames.size()
+                << ",\n  \"frames\": " << total_frames << ",\n  \"frames_skipped\": " << frames_skipped
+                << ",\n  \"dictionary\": " << jsonString(options.dictionary) << ",\n  \"preset\": "
+                << jsonString(options.preset) << ",\n  \"pyramid_level\": " << options.pyramid_level
+                << ",\n  \"tracking\": " << jsonString(options.tracking) << ",\n  \"target_frame_time_ms\": "
+                << fmt(options.target_frame_time_ms) << ",\n  \"final_effort_level\": " << final_effort_level
+                << ",\n  \"fps\": " << fmt(fps) << ",\n  \"stages_ms\": {";
+            for (size_t i = 0; i < stages.size(); ++i)
+            {
+                const RollingStats::Summary summary = stages[i].second->summary(scratch);
+                out << (i ? "," : "") << "\n    \"" << stages[i].first << "\": {\"mean\": " << fmt(summary.mean)
+                    << ", \"p50\": " << fmt(summary.p50) << ", \"p95\": " << fmt(summary.p95)
+                    << ", \"p99\": " << fmt(summary.p99) << ", \"max\": " << fmt(summary.max) << "}";
+            }
+            out << "\n  },\n  \"markers_detected\": " << markers_detected;
+            if (have_truth)
+            {
+                out << ",\n  \"markers_expected\": " << markers_expected << ",\n  \"recall\": " << fmt(recall)
+                    << ",\n  \"false_positives\": " << false_positives;
+            }
+            if (poses_compared > 0)
+            {
+                out << ",\n  \"translation_error_m\": " << fmt(translation_error)
+                    << ",\n  \"rotation_error_deg\": " << fmt(rotation_error);
+            }
+            out << ",\n  \"peak_rss_kb\": " << rss_kb << "\n}\n";
+        }
+        else
+        {
+            if (csv_header)
+            {
+                out << "label,images,frames,frames_skipped,dictionary,preset,pyramid_level,tracking,"
+                       "target_frame_time_ms,final_effort_level,fps";
+                for (const auto &stage : stages)
+                {
+                    for (const char *field : {"mean", "p50", "p95", "p99", "max"})
+                    {
+                        out << "," << stage.first << "_" << field << "_ms";
+                    }
+                }
+                out << ",markers_detected,markers_expected,recall,false_positives,translation_error_m,"
+                       "rotation_error_deg,peak_rss_kb\n";
+            }
+            out << options.label << "," << frames.size() << "," << total_frames << "," << frames_skipped << ","
+                << options.dictionary << "," << options.preset << "," << options.pyramid_level << ","
+                << options.tracking << "," << fmt(options.target_frame_time_ms) << "," << final_effort_level << ","
+                << fmt(fps);
+            for (const auto &stage : stages)
+            {
+                const RollingStats::Summary summary = stage.second->summary(scratch);
+                out << "," << fmt(summary.mean) << "," << fmt(summary.p50) << "," << fmt(summary.p95) << ","
+                    << fmt(summary.p99) << "," << fmt(summary.max);
+            }
+            out << "," << markers_detected << "," << markers_expected << "," << (have_truth ? fmt(recall) : "")
+                << "," << false_positives << "," << (poses_compared > 0 ? fmt(translation_error) : "") << ","
+                << (poses_compared > 0 ? fmt(rotation_error) : "") << "," << rss_kb << "\n";
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "aruco_bench: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
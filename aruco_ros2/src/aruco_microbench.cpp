@@ -0,0 +1,314 @@
+// Microbenchmarks of the per-frame stages, one per function on the hot path, so that a change to one of
+// them can be measured on its own. Frames come from SceneGenerator and are parameterized by resolution
+// (0 = VGA, 1 = HD, 2 = FHD, 3 = 4K, 4 = 8K) and marker count; results report the markers found.
+//
+//   aruco_microbench --benchmark_filter=DetectMarkers --benchmark_out=before.json
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/calib3d.hpp>
+#include <opencv2/opencv.hpp>
+#include <rclcpp/serialization.hpp>
+#include <rclcpp/serialized_message.hpp>
+#include <tf2/LinearMath/Matrix3x3.h>
+#include <tf2/LinearMath/Quaternion.h>
+#include <aruco_ros2_msgs/msg/marker_array.hpp>
+
+#include "aruco_ros2/frame_processing.hpp"
+#include "aruco_ros2/marker_messages.hpp"
+#include "aruco_ros2/square_pose.hpp"
+#include "aruco_ros2/synthetic_scene.hpp"
+
+using namespace aruco_ros2;
+
+namespace
+{
+
+const cv::Size kResolutions[] = {{640, 480}, {1280, 720}, {1920, 1080}, {3840, 2160}, {7680, 4320}};
+const char *const kDictionaries[] = {"DICT_4X4_50", "DICT_5X5_100", "DICT_6X6_250", "DICT_7X7_1000",
+                                     "DICT_ARUCO_ORIGINAL", "DICT_APRILTAG_36h11"};
+const std::vector<int64_t> kResolutionArgs{0, 1, 2, 3, 4};
+const std::vector<int64_t> kMarkerCounts{1, 10, 100, 500};
+
+struct Scene
+{
+    std::string dictionary;
+    cv::Size size;
+    int markers = -1;
+    cv::Mat image; // bgr8
+    std::vector<SceneMarker> truth;
+    std::shared_ptr<const CameraCalibration> calibration;
+};
+
+// The most recently used scene is kept, since consecutive benchmarks usually share it and an 8K frame
+// takes a while to render
+const Scene &scene(const std::string &dictionary, const cv::Size &size, int markers)
+{
+    static Scene cached;
+    if (cached.dictionary != dictionary || cached.size != size || cached.markers != markers)
+    {
+        SceneConfig config;
+        config.image_size = size;
+        config.dictionary_name = dictionary;
+        config.max_tilt_deg = 30.0;
+        config.noise_sigma = 2.0;
+        config.clutter = 20;
+        config.marker_count = std::min<int>(
+            markers, cv::aruco::getPredefinedDictionary(dictNameToEnum(dictionary))->bytesList.rows);
+        cached.dictionary = dictionary;
+        cached.size = size;
+        cached.markers = markers;
+        cached.calibration = makePinholeCalibration(size);
+        SceneGenerator(config, cached.calibration).render(cached.image, cached.truth);
+    }
+    return cached;
+}
+
+DetectorConfig detectorConfig(const std::string &dictionary)
+{
+    DetectorConfig config;
+    config.dictionary_name = dictionary;
+    config.dictionary = cv::aruco::getPredefinedDictionary(dictNameToEnum(dictionary));
+    config.parameters = cv::makePtr<cv::aruco::DetectorParameters>();
+    return config;
+}
+
+// A frame state with the scene's markers as if they had been detected (exact corners), for the stages
+// after detection
+void fillFromTruth(const Scene &scene, FrameState &state)
+{
+    state.marker_ids.clear();
+    state.marker_corners.clear();
+    for (const SceneMarker &marker : scene.truth)
+    {
+        state.marker_ids.push_back(marker.id);
+        state.marker_corners.emplace_back(marker.corners.begin(), marker.corners.end());
+    }
+}
+
+void BM_ConvertBgrToGray(benchmark::State &state)
+{
+    const Scene &frame = scene("DICT_ARUCO_ORIGINAL", kResolutions[state.range(0)], 1);
+    FrameState frame_state;
+    for (auto _ : state)
+    {
+        convertToGray(frame.image, "bgr8", frame_state);
+        benchmark::DoNotOptimize(frame_state.gray.data);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.image.total() * frame.image.elemSize());
+}
+BENCHMARK(BM_ConvertBgrToGray)->ArgsProduct({kResolutionArgs})->Unit(benchmark::kMillisecond);
+
+void runDetection(benchmark::State &state, const std::string &dictionary, const cv::Size &size, int markers)
+{
+    const Scene &frame = scene(dictionary, size, markers);
+    const DetectorConfig config = detectorConfig(dictionary);
+    FrameState frame_state;
+    convertToGray(frame.image, "bgr8", frame_state);
+    resolveDetectorSettings(config, 0, frame_state);
+    for (auto _ : state)
+    {
+        detectFullFrame(config, frame_state);
+    }
+    state.counters["markers"] = static_cast<double>(frame_state.marker_ids.size());
+    state.counters["expected"] = static_cast<double>(frame.truth.size());
+}
+
+void BM_DetectMarkers(benchmark::State &state)
+{
+    runDetection(state, "DICT_ARUCO_ORIGINAL", kResolutions[state.range(0)], static_cast<int>(state.range(1)));
+}
+BENCHMARK(BM_DetectMarkers)->ArgsProduct({kResolutionArgs, kMarkerCounts})->Unit(benchmark::kMillisecond);
+
+// Dictionaries at FHD; arg 0 indexes kDictionaries
+void BM_DetectMarkersByDictionary(benchmark::State &state)
+{
+    runDetection(state, kDictionaries[state.range(0)], kResolutions[2], static_cast<int>(state.range(1)));
+}
+BENCHMARK(BM_DetectMarkersByDictionary)
+    ->ArgsProduct({{0, 1, 2, 3, 4, 5}, {10, 100}})
+    ->Unit(benchmark::kMillisecond);
+
+// Pose estimation of all markers of a frame: OpenCV's iterative per-marker solver, OpenCV's IPPE square
+// solver, and the node's batched IPPE solver (including undistortion)
+void BM_PoseEstimatePoseSingleMarkers(benchmark::State &state)
+{
+    const Scene &frame = scene("DICT_ARUCO_ORIGINAL", kResolutions[state.range(0)], static_cast<int>(state.range(1)));
+    FrameState frame_state;
+    fillFromTruth(frame, frame_state);
+    const cv::Mat &camera_matrix = frame.calibration->cameraMatrix();
+    std::vector<cv::Vec3d> rvecs, tvecs;
+    for (auto _ : state)
+    {
+        cv::aruco::estimatePoseSingleMarkers(frame_state.marker_corners, 0.1f, camera_matrix, cv::Mat(), rvecs, tvecs);
+    }
+    state.counters["markers"] = static_cast<double>(frame_state.marker_ids.size());
+}
+
+void BM_PoseSolvePnPIppeSquare(benchmark::State &state)
+{
+    const Scene &frame = scene("DICT_ARUCO_ORIGINAL", kResolutions[state.range(0)], static_cast<int>(state.range(1)));
+    FrameState frame_state;
+    fillFromTruth(frame, frame_state);
+    const cv::Mat &camera_matrix = frame.calibration->cameraMatrix();
+    const std::vector<cv::Point3f> object{{-0.05f, 0.05f, 0.f}, {0.05f, 0.05f, 0.f}, {0.05f, -0.05f, 0.f}, {-0.05f, -0.05f, 0.f}};
+    cv::Vec3d rvec, tvec;
+    for (auto _ : state)
+    {
+        for (const auto &corners : frame_state.marker_corners)
+        {
+            cv::solvePnP(object, corners, camera_matrix, cv::Mat(), rvec, tvec, false, cv::SOLVEPNP_IPPE_SQUARE);
+        }
+    }
+    state.counters["markers"] = static_cast<double>(frame_state.marker_ids.size());
+}
+
+void BM_PoseSquareBatch(benchmark::State &state)
+{
+    const Scene &frame = scene("DICT_ARUCO_ORIGINAL", kResolutions[state.range(0)], static_cast<int>(state.range(1)));
+    FrameState frame_state;
+    fillFromTruth(frame, frame_state);
+    for (auto _ : state)
+    {
+        solvePoses(*frame.calibration, 0.1, frame_state);
+    }
+    state.counters["markers"] = static_cast<double>(frame_state.marker_ids.size());
+}
+BENCHMARK(BM_PoseEstimatePoseSingleMarkers)->ArgsProduct({{2}, kMarkerCounts})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PoseSolvePnPIppeSquare)->ArgsProduct({{2}, kMarkerCounts})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PoseSquareBatch)->ArgsProduct({{2}, kMarkerCounts})->Unit(benchmark::kMicrosecond);
+
+// Rotation conversions. The quaternions published per marker used to be derived from each solved rvec
+// through cv::Rodrigues and tf2::Matrix3x3::getRotation; the batched solver now outputs them directly, so
+// this times the per-marker cost that path added on top of pose estimation. The `max_error_deg` counter
+// checks it against the solver's quaternions. The quaternion -> rvec conversion is what the overlay uses.
+void BM_RvecToQuaternion(benchmark::State &state)
+{
+    const Scene &frame = scene("DICT_ARUCO_ORIGINAL", kResolutions[2], static_cast<int>(state.range(0)));
+    FrameState frame_state;
+    fillFromTruth(frame, frame_state);
+    solvePoses(*frame.calibration, 0.1, frame_state);
+    const SquarePoseBatch &poses = frame_state.poses;
+    std::vector<tf2::Quaternion> quaternions(frame_state.rvecs.size());
+    cv::Mat r;
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < frame_state.rvecs.size(); ++i)
+        {
+            cv::Rodrigues(frame_state.rvecs[i], r);
+            const tf2::Matrix3x3 rotation(r.at<double>(0, 0), r.at<double>(0, 1), r.at<double>(0, 2),
+                                          r.at<double>(1, 0), r.at<double>(1, 1), r.at<double>(1, 2),
+                                          r.at<double>(2, 0), r.at<double>(2, 1), r.at<double>(2, 2));
+            rotation.getRotation(quaternions[i]);
+        }
+        benchmark::DoNotOptimize(quaternions.data());
+    }
+
+    double max_error = 0.0;
+    for (size_t i = 0; i < quaternions.size(); ++i)
+    {
+        if (!poses.valid[i])
+        {
+            continue;
+        }
+        const tf2::Quaternion &q = quaternions[i];
+        const double dot = q.x() * poses.qx[i] + q.y() * poses.qy[i] + q.z() * poses.qz[i] + q.w() * poses.qw[i];
+        max_error = std::max(max_error, 2.0 * std::acos(std::min(1.0, std::abs(dot))) * 180.0 / CV_PI);
+    }
+    state.counters["markers"] = static_cast<double>(frame_state.rvecs.size());
+    state.counters["max_error_deg"] = max_error;
+}
+
+void BM_QuaternionToRvec(benchmark::State &state)
+{
+    const Scene &frame = scene("DICT_ARUCO_ORIGINAL", kResolutions[2], static_cast<int>(state.range(0)));
+    FrameState frame_state;
+    fillFromTruth(frame, frame_state);
+    solvePoses(*frame.calibration, 0.1, frame_state);
+    const SquarePoseBatch &poses = frame_state.poses;
+    double rvec[3];
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < poses.size(); ++i)
+        {
+            quaternionToRotationVector(poses.qx[i], poses.qy[i], poses.qz[i], poses.qw[i], rvec);
+            benchmark::DoNotOptimize(rvec);
+        }
+    }
+    state.counters["markers"] = static_cast<double>(poses.size());
+}
+BENCHMARK(BM_RvecToQuaternion)->ArgsProduct({kMarkerCounts})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_QuaternionToRvec)->ArgsProduct({kMarkerCounts})->Unit(benchmark::kMicrosecond);
+
+// Overlay: base image, marker outlines and the axes of every marker (drawAxis / draw3dAxis), at full
+// and half scale (arg 2: overlay scale in percent)
+void BM_RenderOverlay(benchmark::State &state)
+{
+    const Scene &frame = scene("DICT_ARUCO_ORIGINAL", kResolutions[state.range(0)], static_cast<int>(state.range(1)));
+    FrameState frame_state;
+    convertToGray(frame.image, "bgr8", frame_state);
+    fillFromTruth(frame, frame_state);
+    solvePoses(*frame.calibration, 0.1, frame_state);
+    const double scale = state.range(2) / 100.0;
+    cv::Mat overlay(cv::Size(static_cast<int>(frame.image.cols * scale), static_cast<int>(frame.image.rows * scale)), CV_8UC3);
+    cv::Mat scratch;
+    for (auto _ : state)
+    {
+        renderOverlay(frame.image, "bgr8", frame_state, *frame.calibration, 0.1, overlay, scratch);
+    }
+    state.counters["markers"] = static_cast<double>(frame_state.marker_ids.size());
+}
+BENCHMARK(BM_RenderOverlay)->ArgsProduct({kResolutionArgs, kMarkerCounts, {100, 50}})->Unit(benchmark::kMillisecond);
+
+// MarkerArray construction as the node does it after pose estimation, and its serialization (what
+// inter-process publishing costs on top)
+void BM_BuildMarkerArray(benchmark::State &state)
+{
+    const Scene &frame = scene("DICT_ARUCO_ORIGINAL", kResolutions[2], static_cast<int>(state.range(0)));
+    FrameState frame_state;
+    fillFromTruth(frame, frame_state);
+    solvePoses(*frame.calibration, 0.1, frame_state);
+    std_msgs::msg::Header header;
+    header.frame_id = "camera_rgb_optical_frame";
+    for (auto _ : state)
+    {
+        aruco_ros2_msgs::msg::MarkerArray array;
+        array.header = header;
+        appendMarkers(frame_state, header, array);
+        benchmark::DoNotOptimize(array.markers.data());
+    }
+    state.counters["markers"] = static_cast<double>(frame_state.marker_ids.size());
+}
+
+void BM_SerializeMarkerArray(benchmark::State &state)
+{
+    const Scene &frame = scene("DICT_ARUCO_ORIGINAL", kResolutions[2], static_cast<int>(state.range(0)));
+    FrameState frame_state;
+    fillFromTruth(frame, frame_state);
+    solvePoses(*frame.calibration, 0.1, frame_state);
+    std_msgs::msg::Header header;
+    header.frame_id = "camera_rgb_optical_frame";
+    aruco_ros2_msgs::msg::MarkerArray array;
+    array.header = header;
+    appendMarkers(frame_state, header, array);
+
+    rclcpp::Serialization<aruco_ros2_msgs::msg::MarkerArray> serialization;
+    rclcpp::SerializedMessage serialized;
+    for (auto _ : state)
+    {
+        serialization.serialize_message(&array, &serialized);
+    }
+    state.counters["markers"] = static_cast<double>(array.markers.size());
+    state.counters["bytes"] = static_cast<double>(serialized.size());
+}
+BENCHMARK(BM_BuildMarkerArray)->ArgsProduct({kMarkerCounts})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SerializeMarkerArray)->ArgsProduct({kMarkerCounts})->Unit(benchmark::kMicrosecond);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -1,385 +1,1446 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
 #include <rclcpp/rclcpp.hpp>
+#include <rclcpp/version.h>
+#include <rclcpp_components/register_node_macro.hpp>
 #include <std_msgs/msg/string.hpp>
 #include <sensor_msgs/msg/image.hpp>
+#include <sensor_msgs/image_encodings.hpp>
 #include <opencv2/opencv.hpp>
 #include <opencv2/aruco.hpp>
 #include <cv_bridge/cv_bridge.h>
 #include <image_transport/image_transport.hpp>
+#include <image_transport/subscriber_filter.hpp>
+#include <message_filters/subscriber.h>
+#include <message_filters/time_synchronizer.h>
 #include <tf2_ros/transform_broadcaster.h>
 #include <geometry_msgs/msg/transform_stamped.hpp>
+#include <camera_calibration_parsers/parse.hpp>
 #include <aruco_ros2_msgs/msg/marker.hpp>
 #include <aruco_ros2_msgs/msg/marker_array.hpp>
 #include <tf2_ros/transform_listener.h>
 #include <tf2_ros/buffer.h>
 #include <tf2_geometry_msgs/tf2_geometry_msgs.hpp>
-#include "rclcpp/wait_for_message.hpp"
+#include <diagnostic_msgs/msg/diagnostic_array.hpp>
+#include <std_srvs/srv/trigger.hpp>
+
+#include "aruco_ros2/budget_controller.hpp"
+#include "aruco_ros2/camera_calibration.hpp"
+#include "aruco_ros2/detector_parameters.hpp"
+#include "aruco_ros2/event_count.hpp"
+#include "aruco_ros2/frame_processing.hpp"
+#include "aruco_ros2/mailbox.hpp"
+#include "aruco_ros2/marker_detector.hpp"
+#include "aruco_ros2/marker_messages.hpp"
+#include "aruco_ros2/reorder_buffer.hpp"
+#include "aruco_ros2/rolling_stats.hpp"
+#include "aruco_ros2/snapshot.hpp"
+#include "aruco_ros2/spsc_queue.hpp"
+#include "aruco_ros2/square_pose.hpp"
+#include "aruco_ros2/trace_recorder.hpp"
+
+// Post-set-parameters callbacks arrived with rclcpp 21 (Iron); Humble ships rclcpp 16
+#if RCLCPP_VERSION_GTE(21, 0, 0)
+#define ARUCO_ROS2_HAS_POST_SET_PARAMETERS_CALLBACK 1
+#else
+#define ARUCO_ROS2_HAS_POST_SET_PARAMETERS_CALLBACK 0
+#endif
 
 using namespace std::chrono_literals;
 
+namespace aruco_ros2
+{
+
+// Images or camera infos the synchronizer keeps while waiting for the message with the matching stamp
+constexpr uint32_t kSyncQueueSize = 5;
+
+// Where a frame's time went, in milliseconds. Stage times use the steady clock; the input age is the
+// ROS clock minus the image stamp when the frame entered the pipeline.
+struct FrameTimings
+{
+    double input_age = 0.0;
+    double conversion = 0.0;
+    double detection = 0.0;
+    double pose = 0.0;
+    double publish = 0.0;
+};
+
+// Rolling distributions of the stage timings and per-frame counts of one camera
+struct CameraMetrics
+{
+    RollingStats input_age_ms;
+    RollingStats conversion_ms;
+    RollingStats detection_ms;
+    RollingStats pose_ms;
+    RollingStats publish_ms;
+    RollingStats overlay_ms;
+    RollingStats latency_ms; // input age when the markers were published
+    RollingStats markers;
+    RollingStats rejected_candidates;
+};
+
+// Per-frame state handed from one pipeline stage to the next. The FrameState buffers are kept when the
+// job is recycled.
+struct FrameJob : FrameState
+{
+    uint64_t seq = 0; // position in input order, assigned by the conversion stage
+    sensor_msgs::msg::Image::ConstSharedPtr msg;
+    cv_bridge::CvImageConstPtr cv_image;
+    std::shared_ptr<const CameraCalibration> calibration; // the calibration current when the frame arrived
+    std::shared_ptr<const DetectorConfig> config;         // set by the detection stage
+    int effort_level = 0;
+    bool full_scan = true;
+    FrameTimings timings;
+};
+using FrameJobPtr = std::unique_ptr<FrameJob>;
+
+// A received frame together with the calibration it was published with
+struct FrameInput
+{
+    sensor_msgs::msg::Image::ConstSharedPtr msg;
+    std::shared_ptr<const CameraCalibration> calibration;
+};
+
+// Everything the node keeps per input camera: topics, calibration, the camera's own pipeline stages and
+// tracking state. Detection workers are shared by all cameras.
+struct Camera
+{
+    size_t index = 0;
+    std::string image_topic;
+    std::string camera_info_topic;
+    std::string camera_frame;
+    std::string calibration_file; // when set, the calibration comes from here and camera info is not subscribed
+
+    // Image and camera info are received together, matched by stamp, as image_transport's
+    // CameraSubscriber does (but with a freely chosen info topic)
+    image_transport::SubscriberFilter image_subscriber;
+    message_filters::Subscriber<sensor_msgs::msg::CameraInfo> camera_info_subscriber;
+    std::unique_ptr<message_filters::TimeSynchronizer<sensor_msgs::msg::Image, sensor_msgs::msg::CameraInfo>> synchronizer;
+    rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr image_pub;
+
+    // Replaced as a whole when the calibration changes; access through load_calibration() and
+    // store_calibration() since pipeline threads read it concurrently
+    std::shared_ptr<const CameraCalibration> calibration;
+
+    std::shared_ptr<const CameraCalibration> load_calibration() const { return std::atomic_load(&calibration); }
+    void store_calibration(std::shared_ptr<const CameraCalibration> value) { std::atomic_store(&calibration, std::move(value)); }
+
+    // The CameraInfo fields the calibration was last checked against. Every frame carries its info, so
+    // these are compared first and the calibration is only looked at again when one of them changes.
+    std::array<double, 9> last_k{};
+    std::array<double, 12> last_p{};
+    std::vector<double> last_d;
+    uint32_t last_width = 0;
+    uint32_t last_height = 0;
+    std::string last_distortion_model;
+
+    // Latest-frame hand-off to the pipeline, and the bounded queues between its stages. There is one
+    // detection and one result queue per shared worker, so every hand-off stays single-producer.
+    Mailbox<FrameInput> mailbox;
+    std::vector<std::unique_ptr<SpscQueue<FrameJobPtr>>> detection_queues;
+    std::vector<std::unique_ptr<SpscQueue<FrameJobPtr>>> result_queues;
+    SpscQueue<FrameJobPtr> overlay_queue{2};
+    // Idle pose and overlay stages sleep on these until the stage before them pushes
+    EventCount results_event;
+    EventCount overlay_event;
+    SpscQueue<FrameJobPtr> pose_recycle_queue{8};
+    SpscQueue<FrameJobPtr> overlay_recycle_queue{8};
+
+    // Frames are numbered by the conversion stage and put back in order by the pose stage
+    uint64_t next_seq = 0;
+    size_t next_worker = 0;
+    std::unique_ptr<ReorderBuffer<FrameJobPtr>> reorder_buffer;
+    rclcpp::Time last_published_stamp{0, 0, RCL_ROS_TIME};
+
+    // Detection and the tracking state it carries between the camera's frames
+    std::unique_ptr<MarkerDetector> detector;
+
+    // Frame-time budget (null when target_frame_time_ms is 0). Frames skipped to stay in budget never
+    // enter the pipeline.
+    std::unique_ptr<BudgetController> budget;
+    uint64_t frames_seen = 0;
+
+    // Written by the pose and overlay stages, read by the metrics timer
+    std::mutex metrics_mutex;
+    CameraMetrics metrics;
+
+    // Debug overlay
+    std::chrono::steady_clock::time_point last_overlay_time;
+    cv::Mat overlay_scratch;
+
+    // Frame counters. Superseded frames were replaced in the mailbox by a newer one before the pipeline
+    // picked them up; dropped frames could not be converted or finished detection too late to be published
+    // in order.
+    std::atomic<uint64_t> frames_received{0};
+    std::atomic<uint64_t> frames_processed{0};
+    std::atomic<uint64_t> frames_superseded{0};
+    std::atomic<uint64_t> frames_dropped{0};
+    std::atomic<uint64_t> frames_skipped{0};
+    uint64_t last_reported_dropped = 0;
+    uint64_t last_reported_superseded = 0;
+    uint64_t last_reported_skipped = 0;
+};
+
 class ArucoRos2Node : public rclcpp::Node
 {
 public:
-    ArucoRos2Node() : Node("aruco_ros2"), tf_buffer_(this->get_clock()), tf_listener_(tf_buffer_)
+    explicit ArucoRos2Node(const rclcpp::NodeOptions &options)
+        : Node("aruco_ros2", options), tf_buffer_(this->get_clock()), tf_listener_(tf_buffer_)
     {
         this->declare_parameter("marker_size", 0.1);
         this->declare_parameter("camera_frame", "camera_rgb_optical_frame");
         this->declare_parameter("image_topic", "/camera/color/image_raw");
         this->declare_parameter("camera_info_topic", "/camera/color/camera_info");
+        this->declare_parameter("image_topics", std::vector<std::string>{});
+        this->declare_parameter("camera_info_topics", std::vector<std::string>{});
+        this->declare_parameter("camera_frames", std::vector<std::string>{});
+        this->declare_parameter("calibration_file", "");
+        this->declare_parameter("calibration_files", std::vector<std::string>{});
+        this->declare_parameter("warmup", false);
+        this->declare_parameter("warmup_width", 0);
+        this->declare_parameter("warmup_height", 0);
+        this->declare_parameter("opencv_threads", -1);
         this->declare_parameter("dictionary", "DICT_ARUCO_ORIGINAL");
+        this->declare_parameter("overlay_rate", 0.0);
+        this->declare_parameter("overlay_scale", 1.0);
+        this->declare_parameter("detection_workers", 1);
+        this->declare_parameter("max_reorder_latency_ms", 100.0);
+        this->declare_parameter("tracking", "none");
+        this->declare_parameter("full_scan_interval", 10);
+        this->declare_parameter("roi_padding", 0.5);
+        this->declare_parameter("klt_verify_interval", 3);
+        this->declare_parameter("pyramid_level", 0);
+        this->declare_parameter("target_frame_time_ms", 0.0);
+        this->declare_parameter("metrics_period", 5.0);
+        this->declare_parameter("trace", false);
+        this->declare_parameter("trace_capacity", 65536);
+        this->declare_parameter("trace_file", "aruco_ros2_trace.json");
+
+        overlay_rate_ = this->get_parameter("overlay_rate").as_double();
+        overlay_scale_ = std::clamp(this->get_parameter("overlay_scale").as_double(), 0.05, 1.0);
+        detection_workers_ = static_cast<size_t>(std::max<int64_t>(1, this->get_parameter("detection_workers").as_int()));
+        max_reorder_latency_ms_ = std::max(0.0, this->get_parameter("max_reorder_latency_ms").as_double());
+        tracking_ = this->get_parameter("tracking").as_string();
+        full_scan_interval_ = static_cast<int>(this->get_parameter("full_scan_interval").as_int());
+        roi_padding_ = this->get_parameter("roi_padding").as_double();
+        klt_verify_interval_ = static_cast<int>(this->get_parameter("klt_verify_interval").as_int());
+        opencv_threads_ = static_cast<int>(this->get_parameter("opencv_threads").as_int());
+        target_frame_time_ms_ = std::max(0.0, this->get_parameter("target_frame_time_ms").as_double());
+        metrics_period_ = std::max(0.0, this->get_parameter("metrics_period").as_double());
+        trace_file_ = this->get_parameter("trace_file").as_string();
+        if (this->get_parameter("trace").as_bool())
+        {
+            tracer_ = std::make_unique<TraceRecorder>(
+                static_cast<size_t>(std::max<int64_t>(1, this->get_parameter("trace_capacity").as_int())));
+        }
+        warmup_ = this->get_parameter("warmup").as_bool();
+        warmup_size_ = cv::Size(static_cast<int>(this->get_parameter("warmup_width").as_int()),
+                                static_cast<int>(this->get_parameter("warmup_height").as_int()));
+        declare_cameras();
+        auto config = std::make_shared<DetectorConfig>();
+        config->marker_size = this->get_parameter("marker_size").as_double();
+        config->dictionary_name = this->get_parameter("dictionary").as_string();
+        config->dictionary = cv::aruco::getPredefinedDictionary(dictNameToEnum(config->dictionary_name));
+        config->pyramid_level = std::clamp(static_cast<int>(this->get_parameter("pyramid_level").as_int()), 0, 4);
+        config->parameters = declare_detector_parameters();
+        detector_config_.publish(config);
+
+        RCLCPP_INFO(this->get_logger(), "marker_size: %f", config->marker_size);
+        for (const auto &camera : cameras_)
+        {
+            RCLCPP_INFO(this->get_logger(), "camera %zu: image_topic: %s, camera_info_topic: %s, camera_frame: %s",
+                        camera->index, camera->image_topic.c_str(), camera->camera_info_topic.c_str(),
+                        camera->camera_frame.c_str());
+            if (!camera->calibration_file.empty())
+            {
+                RCLCPP_INFO(this->get_logger(), "camera %zu: calibration_file: %s", camera->index,
+                            camera->calibration_file.c_str());
+            }
+        }
+        RCLCPP_INFO(this->get_logger(), "dictionary: %s", config->dictionary_name.c_str());
+        RCLCPP_INFO(this->get_logger(), "detector_preset: %s", detector_preset_.c_str());
+        log_detector_parameters(*config->parameters);
+        RCLCPP_INFO(this->get_logger(), "overlay_rate: %f", overlay_rate_);
+        RCLCPP_INFO(this->get_logger(), "overlay_scale: %f", overlay_scale_);
+        RCLCPP_INFO(this->get_logger(), "detection_workers: %zu", detection_workers_);
+        RCLCPP_INFO(this->get_logger(), "max_reorder_latency_ms: %f", max_reorder_latency_ms_);
+        RCLCPP_INFO(this->get_logger(), "tracking: %s", tracking_.c_str());
+        RCLCPP_INFO(this->get_logger(), "full_scan_interval: %d", full_scan_interval_);
+        RCLCPP_INFO(this->get_logger(), "roi_padding: %f", roi_padding_);
+        RCLCPP_INFO(this->get_logger(), "klt_verify_interval: %d", klt_verify_interval_);
+        RCLCPP_INFO(this->get_logger(), "pyramid_level: %d", config->pyramid_level);
+        RCLCPP_INFO(this->get_logger(), "target_frame_time_ms: %f", target_frame_time_ms_);
+        RCLCPP_INFO(this->get_logger(), "metrics_period: %f", metrics_period_);
+        RCLCPP_INFO(this->get_logger(), "trace: %s", tracer_ ? "true" : "false");
+        RCLCPP_INFO(this->get_logger(), "trace_file: %s", trace_file_.c_str());
+        RCLCPP_INFO(this->get_logger(), "opencv_threads: %d", opencv_threads_);
+        RCLCPP_INFO(this->get_logger(), "warmup: %s", warmup_ ? "true" : "false");
+        RCLCPP_INFO(this->get_logger(), "intra-process comms: %s",
+                    this->get_node_options().use_intra_process_comms() ? "enabled" : "disabled");
+
+        initialize();
+    }
+
+    ~ArucoRos2Node() override
+    {
+        stop_pipeline();
+        if (tracer_)
+        {
+            dump_trace();
+        }
+    }
+
+private:
+    // A single camera comes from image_topic/camera_info_topic/camera_frame/calibration_file. Several
+    // cameras are given as parallel lists in image_topics/camera_info_topics/camera_frames and, optionally,
+    // calibration_files, which take precedence.
+    void declare_cameras()
+    {
+        const auto image_topics = this->get_parameter("image_topics").as_string_array();
+        const auto camera_info_topics = this->get_parameter("camera_info_topics").as_string_array();
+        const auto camera_frames = this->get_parameter("camera_frames").as_string_array();
+        const auto calibration_files = this->get_parameter("calibration_files").as_string_array();
+
+        if (image_topics.empty())
+        {
+            auto camera = std::make_unique<Camera>();
+            camera->image_topic = this->get_parameter("image_topic").as_string();
+            camera->camera_info_topic = this->get_parameter("camera_info_topic").as_string();
+            camera->camera_frame = this->get_parameter("camera_frame").as_string();
+            camera->calibration_file = this->get_parameter("calibration_file").as_string();
+            cameras_.push_back(std::move(camera));
+            return;
+        }
+        if (camera_info_topics.size() != image_topics.size() || camera_frames.size() != image_topics.size())
+        {
+            throw std::invalid_argument("image_topics, camera_info_topics and camera_frames must have the same length");
+        }
+        if (!calibration_files.empty() && calibration_files.size() != image_topics.size())
+        {
+            throw std::invalid_argument("calibration_files must be empty or have the same length as image_topics");
+        }
+        for (size_t i = 0; i < image_topics.size(); ++i)
+        {
+            auto camera = std::make_unique<Camera>();
+            camera->index = i;
+            camera->image_topic = image_topics[i];
+            camera->camera_info_topic = camera_info_topics[i];
+            camera->camera_frame = camera_frames[i];
+            camera->calibration_file = calibration_files.empty() ? "" : calibration_files[i];
+            cameras_.push_back(std::move(camera));
+        }
+    }
+
+    // The detector settings start from detector_preset, and every cv::aruco::DetectorParameters field can
+    // then be overridden individually as detector.<fieldName>
+    cv::Ptr<cv::aruco::DetectorParameters> declare_detector_parameters()
+    {
+        detector_preset_ = this->declare_parameter("detector_preset", "default");
+        auto params = cv::aruco::DetectorParameters::create();
+        if (!applyDetectorPreset(detector_preset_, *params))
+        {
+            std::string names;
+            for (const auto &name : detectorPresetNames())
+            {
+                names += (names.empty() ? "" : ", ") + name;
+            }
+            throw std::invalid_argument("Invalid detector_preset: " + detector_preset_ + " (expected one of " + names + ")");
+        }
+
+        visitDetectorParameters(*params, [this](const char *name, auto &field)
+        {
+            using T = std::decay_t<decltype(field)>;
+            const std::string parameter = std::string("detector.") + name;
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                field = this->declare_parameter<bool>(parameter, field);
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                field = static_cast<T>(this->declare_parameter<int64_t>(parameter, field));
+            }
+            else
+            {
+                field = static_cast<T>(this->declare_parameter<double>(parameter, field));
+            }
+        });
+
+        std::string error;
+        if (!validateDetectorParameters(*params, error))
+        {
+            throw std::invalid_argument("Invalid detector parameters: " + error);
+        }
+        return params;
+    }
+
+    void log_detector_parameters(const cv::aruco::DetectorParameters &params)
+    {
+        RCLCPP_INFO(this->get_logger(), "detector: adaptive threshold windows %d-%d step %d, marker perimeter rate %.3f-%.3f, corner refinement %d",
+                    params.adaptiveThreshWinSizeMin, params.adaptiveThreshWinSizeMax, params.adaptiveThreshWinSizeStep,
+                    params.minMarkerPerimeterRate, params.maxMarkerPerimeterRate, params.cornerRefinementMethod);
+    }
+
+    // Applies changes to marker_size, dictionary, pyramid_level and detector.* while running, in two
+    // steps: validate_parameters() rejects invalid values as a whole before anything is committed, and
+    // commit_parameters() runs once every set-parameters callback has accepted them. The new settings are
+    // built there, on the executor thread, into a fresh snapshot that the detection workers pick up with
+    // their next frame; they never wait for either callback. Post-set callbacks only exist from Iron on;
+    // on Humble the snapshot is published from validate_parameters() once the values are accepted, which
+    // is equivalent as long as this node registers no other set-parameters callback.
+    rcl_interfaces::msg::SetParametersResult validate_parameters(const std::vector<rclcpp::Parameter> &parameters)
+    {
+        rcl_interfaces::msg::SetParametersResult result;
+        result.successful = true;
+        try
+        {
+            bool changed = false;
+            auto config = apply_parameters(*detector_config_.load(), parameters, changed);
+#if !ARUCO_ROS2_HAS_POST_SET_PARAMETERS_CALLBACK
+            if (changed)
+            {
+                publish_config(config);
+            }
+#endif
+        }
+        catch (const std::exception &e)
+        {
+            result.successful = false;
+            result.reason = e.what();
+        }
+        return result;
+    }
+
+#if ARUCO_ROS2_HAS_POST_SET_PARAMETERS_CALLBACK
+    void commit_parameters(const std::vector<rclcpp::Parameter> &parameters)
+    {
+        bool changed = false;
+        auto config = apply_parameters(*detector_config_.load(), parameters, changed);
+        if (changed)
+        {
+            publish_config(config);
+        }
+    }
+#endif
+
+    void publish_config(const std::shared_ptr<DetectorConfig> &config)
+    {
+        detector_config_.publish(config);
+        RCLCPP_INFO(this->get_logger(), "Detector reconfigured: dictionary %s, marker_size %f, pyramid_level %d",
+                    config->dictionary_name.c_str(), config->marker_size, config->pyramid_level);
+        log_detector_parameters(*config->parameters);
+    }
 
-        marker_size_ = this->get_parameter("marker_size").as_double();
-        camera_frame_ = this->get_parameter("camera_frame").as_string();
-        image_topic_ = this->get_parameter("image_topic").as_string();
-        camera_info_topic_ = this->get_parameter("camera_info_topic").as_string();
-        dictionary_ = this->get_parameter("dictionary").as_string();
+    // Returns a copy of `current` with the detector-related `parameters` applied. Throws
+    // std::invalid_argument for an invalid value.
+    std::shared_ptr<DetectorConfig> apply_parameters(const DetectorConfig &current,
+                                                     const std::vector<rclcpp::Parameter> &parameters, bool &changed)
+    {
+        auto config = std::make_shared<DetectorConfig>(current);
+        config->parameters = cv::makePtr<cv::aruco::DetectorParameters>(*current.parameters);
+        for (const auto &parameter : parameters)
+        {
+            const std::string &name = parameter.get_name();
+            if (name == "marker_size")
+            {
+                config->marker_size = parameter.as_double();
+                if (!(config->marker_size > 0.0))
+                {
+                    throw std::invalid_argument("marker_size must be positive");
+                }
+            }
+            else if (name == "dictionary")
+            {
+                config->dictionary_name = parameter.as_string();
+                config->dictionary = cv::aruco::getPredefinedDictionary(dictNameToEnum(config->dictionary_name));
+            }
+            else if (name == "pyramid_level")
+            {
+                config->pyramid_level = std::clamp(static_cast<int>(parameter.as_int()), 0, 4);
+            }
+            else if (name == "detector_preset")
+            {
+                throw std::invalid_argument("detector_preset only applies at startup; change detector.* parameters instead");
+            }
+            else if (name.rfind("detector.", 0) == 0)
+            {
+                if (!setDetectorField(*config->parameters, name.substr(9), parameter))
+                {
+                    throw std::invalid_argument("Unknown detector parameter: " + name);
+                }
+            }
+            else
+            {
+                continue;
+            }
+            changed = true;
+        }
+        std::string error;
+        if (!validateDetectorParameters(*config->parameters, error))
+        {
+            throw std::invalid_argument(error);
+        }
+        return config;
+    }
 
-        RCLCPP_INFO(this->get_logger(), "marker_size: %f", marker_size_);
-        RCLCPP_INFO(this->get_logger(), "camera_frame: %s", camera_frame_.c_str());
-        RCLCPP_INFO(this->get_logger(), "image_topic: %s", image_topic_.c_str());
-        RCLCPP_INFO(this->get_logger(), "camera_info_topic: %s", camera_info_topic_.c_str());
-        RCLCPP_INFO(this->get_logger(), "dictionary: %s", dictionary_.c_str());
+    static bool setDetectorField(cv::aruco::DetectorParameters &params, const std::string &field_name,
+                                 const rclcpp::Parameter &parameter)
+    {
+        bool found = false;
+        visitDetectorParameters(params, [&](const char *name, auto &field)
+        {
+            using T = std::decay_t<decltype(field)>;
+            if (found || field_name != name)
+            {
+                return;
+            }
+            found = true;
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                field = parameter.as_bool();
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                field = static_cast<T>(parameter.as_int());
+            }
+            else
+            {
+                field = static_cast<T>(parameter.as_double());
+            }
+        });
+        return found;
     }
 
     void initialize()
     {
         RCLCPP_INFO(this->get_logger(), "Initializing.");
 
-        // Image transport subscriber
-        it_ = std::make_unique<image_transport::ImageTransport>(shared_from_this());
-        image_subscriber_ = it_->subscribe(image_topic_, 1,
-                                           std::bind(&ArucoRos2Node::image_callback, this, std::placeholders::_1));
+        // All cameras share the detection workers; optionally bound OpenCV's own thread pool as well so the
+        // total CPU usage stays predictable
+        if (opencv_threads_ >= 0)
+        {
+            cv::setNumThreads(opencv_threads_);
+        }
 
         // Publisher for marker information
         marker_info_publisher_ = this->create_publisher<std_msgs::msg::String>("aruco_marker_info", 10);
         marker_array_pub_ = this->create_publisher<aruco_ros2_msgs::msg::MarkerArray>("/aruco/markers", 10);
 
-        // Image publisher
-        image_pub_ = this->create_publisher<sensor_msgs::msg::Image>("/aruco/result", 10);
-
         // TF broadcaster for publishing transforms
         tf_broadcaster_ = std::make_shared<tf2_ros::TransformBroadcaster>(*this);
 
-        // Set up ArUco marker detector
-        aruco_dict_ = cv::aruco::getPredefinedDictionary(this->dictNameToEnum(dictionary_));
-        aruco_parameters_ = cv::aruco::DetectorParameters::create();
+        if (!parseTrackingMode(tracking_, tracking_config_.mode))
+        {
+            throw std::invalid_argument("Invalid tracking mode: " + tracking_);
+        }
+        tracking_config_.full_scan_interval = full_scan_interval_;
+        tracking_config_.roi_padding = roi_padding_;
+        tracking_config_.klt_verify_interval = klt_verify_interval_;
+
+        for (auto &camera : cameras_)
+        {
+            initialize_camera(*camera);
+            if (warmup_)
+            {
+                warm_up(*camera);
+            }
+        }
+
+        // Frames are processed by a pipeline of stage threads fed through a single-slot mailbox per camera,
+        // so a slow frame never queues up behind the subscription or starves the executor, and frame N+1
+        // can be detected while frame N is being published
+        start_pipeline();
+        stats_timer_ = this->create_wall_timer(10s, std::bind(&ArucoRos2Node::log_frame_stats, this));
+
+        // Stage latency distributions, as diagnostics
+        if (metrics_period_ > 0.0)
+        {
+            diagnostics_pub_ = this->create_publisher<diagnostic_msgs::msg::DiagnosticArray>("/diagnostics", 10);
+            metrics_timer_ = this->create_wall_timer(std::chrono::duration<double>(metrics_period_),
+                                                     std::bind(&ArucoRos2Node::publish_metrics, this));
+        }
+
+        // Per-frame stage spans, dumped as a Chrome trace on request and at shutdown
+        if (tracer_)
+        {
+            dump_trace_service_ = this->create_service<std_srvs::srv::Trigger>(
+                "~/dump_trace", [this](const std::shared_ptr<std_srvs::srv::Trigger::Request>,
+                                       std::shared_ptr<std_srvs::srv::Trigger::Response> response)
+                { response->success = dump_trace(response->message); });
+        }
 
-        RCLCPP_INFO(this->get_logger(), "Waiting for camera info.");
-        sensor_msgs::msg::CameraInfo camera_info;
-        rclcpp::wait_for_message<sensor_msgs::msg::CameraInfo>(
-            camera_info,
-            shared_from_this(), camera_info_topic_);
-        RCLCPP_INFO(this->get_logger(), "Camera info received.");
-        process_camera_info(camera_info);
+        parameter_callback_ = this->add_on_set_parameters_callback(
+            std::bind(&ArucoRos2Node::validate_parameters, this, std::placeholders::_1));
+#if ARUCO_ROS2_HAS_POST_SET_PARAMETERS_CALLBACK
+        post_parameter_callback_ = this->add_post_set_parameters_callback(
+            std::bind(&ArucoRos2Node::commit_parameters, this, std::placeholders::_1));
+#endif
     }
 
-private:
-    void process_camera_info(const sensor_msgs::msg::CameraInfo &msg)
+    void initialize_camera(Camera &camera)
     {
-        camera_matrix_ = cv::Mat(3, 3, CV_64F, (void *)msg.k.data()).clone();
-        camera_distortion_ = cv::Mat::zeros(1, 4, CV_64F);
-        if (!msg.d.empty())
+        // Image transport subscriber, synchronized with the camera info. The raw transport hands us the
+        // publisher's shared pointer, so when loaded into the camera driver's container with
+        // use_intra_process_comms the frame is never copied.
+        rmw_qos_profile_t image_qos = rmw_qos_profile_default;
+        image_qos.depth = 1;
+        camera.image_subscriber.subscribe(this, camera.image_topic, "raw", image_qos);
+        if (!camera.calibration_file.empty())
         {
-            camera_distortion_ = cv::Mat(1, static_cast<int>(msg.d.size()), CV_64F);
-            for (size_t i = 0; i < msg.d.size(); ++i)
+            // Calibration from file: detection can start with the first image, without waiting for (or
+            // subscribing to) camera info
+            sensor_msgs::msg::CameraInfo info;
+            std::string camera_name;
+            if (!camera_calibration_parsers::readCalibration(camera.calibration_file, camera_name, info))
             {
-                camera_distortion_.at<double>(0, i) = msg.d[i];
+                throw std::invalid_argument("Could not read calibration file: " + camera.calibration_file);
             }
+            process_camera_info(camera, info);
+            std::function<void(const sensor_msgs::msg::Image::ConstSharedPtr &)> callback =
+                [this, &camera](const sensor_msgs::msg::Image::ConstSharedPtr &msg)
+            { image_callback(camera, msg, nullptr); };
+            camera.image_subscriber.registerCallback(callback);
+            RCLCPP_INFO(this->get_logger(), "Waiting for images on %s.", camera.image_topic.c_str());
+        }
+        else
+        {
+            camera.camera_info_subscriber.subscribe(this, camera.camera_info_topic, rmw_qos_profile_default);
+            camera.synchronizer = std::make_unique<message_filters::TimeSynchronizer<sensor_msgs::msg::Image, sensor_msgs::msg::CameraInfo>>(
+                camera.image_subscriber, camera.camera_info_subscriber, kSyncQueueSize);
+            std::function<void(const sensor_msgs::msg::Image::ConstSharedPtr &, const sensor_msgs::msg::CameraInfo::ConstSharedPtr &)> callback =
+                [this, &camera](const sensor_msgs::msg::Image::ConstSharedPtr &msg, const sensor_msgs::msg::CameraInfo::ConstSharedPtr &info)
+            { image_callback(camera, msg, info.get()); };
+            camera.synchronizer->registerCallback(callback);
+            RCLCPP_INFO(this->get_logger(), "Waiting for images on %s with camera info on %s.",
+                        camera.image_topic.c_str(), camera.camera_info_topic.c_str());
+        }
+
+        // Image publisher. With several cameras each one gets its own overlay topic.
+        const std::string result_topic = cameras_.size() == 1 ? "/aruco/result" : "/aruco/result_" + std::to_string(camera.index);
+        camera.image_pub = this->create_publisher<sensor_msgs::msg::Image>(result_topic, 10);
+
+        // Tracking modes: after a full-frame scan, either search only around where the known markers are
+        // expected ("roi"), or follow their corners with optical flow until the next keyframe ("klt")
+        camera.detector = std::make_unique<MarkerDetector>(tracking_config_);
+
+        if (target_frame_time_ms_ > 0.0)
+        {
+            BudgetControllerConfig budget_config;
+            budget_config.target_ms = target_frame_time_ms_;
+            camera.budget = std::make_unique<BudgetController>(budget_config);
+        }
+    }
+
+    // Keeps the camera's calibration in step with the CameraInfo that arrived with a frame. Unchanged
+    // info (the normal case) costs a comparison of a few arrays; when K, D, P, the resolution or the
+    // distortion model change (zoom, mode switch) the calibration is rebuilt and swapped in, and frames
+    // already in the pipeline finish with the one they arrived with.
+    void process_camera_info(Camera &camera, const sensor_msgs::msg::CameraInfo &msg)
+    {
+        if (camera.load_calibration() && msg.width == camera.last_width && msg.height == camera.last_height &&
+            std::equal(msg.k.begin(), msg.k.end(), camera.last_k.begin()) &&
+            std::equal(msg.p.begin(), msg.p.end(), camera.last_p.begin()) && msg.d == camera.last_d &&
+            msg.distortion_model == camera.last_distortion_model)
+        {
+            return;
+        }
+        std::copy(msg.k.begin(), msg.k.end(), camera.last_k.begin());
+        std::copy(msg.p.begin(), msg.p.end(), camera.last_p.begin());
+        camera.last_d = msg.d;
+        camera.last_width = msg.width;
+        camera.last_height = msg.height;
+        camera.last_distortion_model = msg.distortion_model;
+
+        const cv::Size image_size(static_cast<int>(msg.width), static_cast<int>(msg.height));
+        const cv::Mat camera_matrix(3, 3, CV_64F, const_cast<double *>(msg.k.data()));
+        const cv::Mat distortion = msg.d.empty() ? cv::Mat::zeros(1, 4, CV_64F)
+                                                 : cv::Mat(1, static_cast<int>(msg.d.size()), CV_64F, const_cast<double *>(msg.d.data()));
+
+        DistortionModel model;
+        if (!parseDistortionModel(msg.distortion_model, model))
+        {
+            RCLCPP_WARN_ONCE(this->get_logger(), "Unsupported distortion model '%s', treating it as plumb_bob.",
+                             msg.distortion_model.c_str());
+            model = DistortionModel::PlumbBob;
+        }
+
+        // The derived state (undistortion table) is only rebuilt when the calibration actually changes
+        const auto current = camera.load_calibration();
+        if (current && current->matches(image_size, camera_matrix, distortion, model))
+        {
+            return;
         }
+        camera.store_calibration(std::make_shared<const CameraCalibration>(image_size, camera_matrix, distortion, model));
 
-        if (!received_camera_info_)
         {
-            RCLCPP_INFO(this->get_logger(), "Received camera info.");
+            std::stringstream d;
+            for (size_t i = 0; i < msg.d.size(); ++i)
+            {
+                d << (i ? ", " : "") << msg.d[i];
+            }
+            RCLCPP_INFO(this->get_logger(), current ? "Camera calibration changed." : "Received camera info.");
             RCLCPP_INFO(this->get_logger(), "Camera Info:\n"
                                             "\tWidth: %d\n"
                                             "\tHeight: %d\n"
                                             "\tK (intrinsic matrix): [%f, %f, %f, %f, %f, %f, %f, %f, %f]\n"
-                                            "\tD (distortion coefficients): [%f, %f, %f, %f, %f]",
+                                            "\tDistortion model: %s\n"
+                                            "\tD (distortion coefficients): [%s]",
                         msg.width,
                         msg.height,
                         msg.k[0], msg.k[1], msg.k[2], msg.k[3], msg.k[4], msg.k[5], msg.k[6], msg.k[7], msg.k[8],
-                        msg.d[0], msg.d[1], msg.d[2], msg.d[3], msg.d[4]);
-            received_camera_info_ = true;
+                        distortionModelName(model), d.str().c_str());
         }
     }
 
-    void log_marker_ids(const std::vector<int> &ids)
+    // Runs the detector and pose solver on a synthetic frame (a marker of the configured dictionary on a
+    // white background) at the camera's resolution, so OpenCV's lazy allocations, its thread pool and the
+    // job buffers are set up before the first live frame arrives
+    void warm_up(Camera &camera)
     {
-        std::stringstream ss;
-        for (size_t i = 0; i < ids.size(); ++i)
+        auto calibration = camera.load_calibration();
+        cv::Size size = warmup_size_;
+        if (size.area() <= 0 && calibration)
+        {
+            size = calibration->imageSize();
+        }
+        if (size.area() <= 0)
+        {
+            RCLCPP_WARN(this->get_logger(), "Skipping warm-up of camera %zu: resolution unknown, set calibration_file or warmup_width/warmup_height.",
+                        camera.index);
+            return;
+        }
+        if (!calibration || calibration->imageSize() != size)
+        {
+            const cv::Mat camera_matrix = (cv::Mat_<double>(3, 3) << size.width, 0, size.width / 2.0,
+                                           0, size.width, size.height / 2.0,
+                                           0, 0, 1);
+            calibration = std::make_shared<const CameraCalibration>(size, camera_matrix, cv::Mat());
+        }
+
+        const auto config = detector_config_.load();
+        const auto start = std::chrono::steady_clock::now();
+        cv::Mat frame(size, CV_8UC3, cv::Scalar(255, 255, 255));
+        const int side = std::max(16, std::min(size.width, size.height) / 4);
+        if (side < size.width && side < size.height)
+        {
+            cv::Mat marker;
+            cv::aruco::drawMarker(config->dictionary, 0, side, marker, config->parameters->markerBorderBits);
+            cv::Mat target = frame(cv::Rect((size.width - side) / 2, (size.height - side) / 2, side, side));
+            cv::cvtColor(marker, target, cv::COLOR_GRAY2BGR);
+        }
+
+        FrameJobPtr job = acquire_job(camera);
+        job->config = config;
+        job->effort_level = 0;
+        resolveDetectorSettings(*config, 0, *job);
+        for (int pass = 0; pass < 2; ++pass)
         {
-            ss << ids[i];
-            if (i != ids.size() - 1)
+            convertToGray(frame, sensor_msgs::image_encodings::BGR8, *job);
+            job->calibration = calibration;
+            detectFullFrame(*config, *job);
+            if (!job->marker_ids.empty())
             {
-                ss << ", "; // Add a separator between elements
+                solvePoses(*calibration, config->marker_size, *job);
             }
         }
-        RCLCPP_INFO(this->get_logger(), "marker ids: %s", ss.str().c_str());
+        const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        RCLCPP_INFO(this->get_logger(), "Warm-up of camera %zu at %dx%d took %.1f ms (%zu marker(s) found).",
+                    camera.index, size.width, size.height, elapsed_ms, job->marker_ids.size());
+        recycle_job(camera.pose_recycle_queue, std::move(job));
+    }
+
+    // Callback for the synchronized image and camera info (no info when calibrated from a file). Brings
+    // the calibration up to date and hands the frame to the pipeline; if the conversion stage has not
+    // picked up the previous frame yet, that one is superseded.
+    void image_callback(Camera &camera, const sensor_msgs::msg::Image::ConstSharedPtr &msg,
+                        const sensor_msgs::msg::CameraInfo *info)
+    {
+        camera.frames_received++;
+        if (info)
+        {
+            process_camera_info(camera, *info);
+        }
+        if (camera.mailbox.put(FrameInput{msg, camera.load_calibration()}))
+        {
+            camera.frames_superseded++;
+        }
     }
 
-    // Callback for image subscription
-    void image_callback(const sensor_msgs::msg::Image::ConstSharedPtr msg)
+    void log_frame_stats()
     {
-        if (!received_camera_info_)
+        for (auto &camera : cameras_)
+        {
+            const uint64_t dropped = camera->frames_dropped;
+            const uint64_t superseded = camera->frames_superseded;
+            const uint64_t skipped = camera->frames_skipped;
+            if (dropped == camera->last_reported_dropped && superseded == camera->last_reported_superseded &&
+                skipped == camera->last_reported_skipped)
+            {
+                continue;
+            }
+            RCLCPP_INFO(this->get_logger(), "%s: frames received: %lu, processed: %lu, superseded: %lu, dropped: %lu, skipped: %lu",
+                        camera->image_topic.c_str(),
+                        static_cast<unsigned long>(camera->frames_received.load()),
+                        static_cast<unsigned long>(camera->frames_processed.load()),
+                        static_cast<unsigned long>(superseded),
+                        static_cast<unsigned long>(dropped),
+                        static_cast<unsigned long>(skipped));
+            camera->last_reported_dropped = dropped;
+            camera->last_reported_superseded = superseded;
+            camera->last_reported_skipped = skipped;
+        }
+    }
+
+    static double elapsed_ms(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Time since the image was stamped; 0 for unstamped images
+    double input_age_ms(const sensor_msgs::msg::Image &msg)
+    {
+        const rclcpp::Time stamp(msg.header.stamp, RCL_ROS_TIME);
+        if (stamp.nanoseconds() == 0)
+        {
+            return 0.0;
+        }
+        return (this->get_clock()->now() - stamp).seconds() * 1000.0;
+    }
+
+    void record_metrics(Camera &camera, const FrameJob &job)
+    {
+        const double latency = input_age_ms(*job.msg);
+        std::lock_guard<std::mutex> lock(camera.metrics_mutex);
+        CameraMetrics &metrics = camera.metrics;
+        metrics.input_age_ms.add(job.timings.input_age);
+        metrics.conversion_ms.add(job.timings.conversion);
+        metrics.detection_ms.add(job.timings.detection);
+        metrics.pose_ms.add(job.timings.pose);
+        metrics.publish_ms.add(job.timings.publish);
+        metrics.latency_ms.add(latency);
+        metrics.markers.add(static_cast<double>(job.marker_ids.size()));
+        metrics.rejected_candidates.add(static_cast<double>(job.rejected_candidates.size()));
+    }
+
+    // Records one stage of a frame, from `start` until now, when tracing is enabled
+    void trace_span(const Camera &camera, const char *name, const FrameJob &job,
+                    std::chrono::steady_clock::time_point start)
+    {
+        if (!tracer_)
         {
-            RCLCPP_INFO(this->get_logger(), "Waiting for camera info.");
             return;
         }
+        const int64_t stamp_ns = rclcpp::Time(job.msg->header.stamp).nanoseconds();
+        tracer_->record(name, camera.index, start, std::chrono::steady_clock::now(), stamp_ns, job.seq,
+                        job.marker_ids.size());
+    }
 
-        aruco_ros2_msgs::msg::MarkerArray marker_array;
-        marker_array.header.stamp = this->get_clock()->now();
-        marker_array.header.frame_id = camera_frame_;
+    void name_trace_thread(const std::string &name)
+    {
+        if (tracer_)
+        {
+            tracer_->nameThread(name);
+        }
+    }
 
-        try
+    bool dump_trace(std::string &message)
+    {
+        std::vector<std::string> camera_names;
+        for (const auto &camera : cameras_)
         {
-            // Convert ROS image message to OpenCV image
-            cv_bridge::CvImagePtr cv_image_ptr = cv_bridge::toCvCopy(msg, sensor_msgs::image_encodings::BGR8);
-            cv::Mat &image = cv_image_ptr->image;
+            camera_names.push_back(camera->image_topic);
+        }
+        const long spans = tracer_->writeChromeTrace(trace_file_, camera_names);
+        if (spans < 0)
+        {
+            message = "could not write " + trace_file_;
+            RCLCPP_ERROR(this->get_logger(), "Trace: %s", message.c_str());
+            return false;
+        }
+        message = "wrote " + std::to_string(spans) + " spans to " + trace_file_;
+        RCLCPP_INFO(this->get_logger(), "Trace: %s", message.c_str());
+        return true;
+    }
+
+    bool dump_trace()
+    {
+        std::string message;
+        return dump_trace(message);
+    }
 
-            // Detect ArUco markers
-            std::vector<int> marker_ids;
-            std::vector<std::vector<cv::Point2f>> marker_corners, rejected_candidates;
-            cv::Mat dist_coeffs = cv::Mat::zeros(4, 1, CV_64F);
-            cv::aruco::detectMarkers(image, aruco_dict_, marker_corners, marker_ids, aruco_parameters_, rejected_candidates, camera_matrix_, camera_distortion_);
+    // Publishes one DiagnosticStatus per camera with p50/p95/p99/max/mean of every stage over the last
+    // frames, the frame counters and, with a frame-time budget, the current effort level
+    void publish_metrics()
+    {
+        diagnostic_msgs::msg::DiagnosticArray array;
+        array.header.stamp = this->get_clock()->now();
+
+        for (auto &camera : cameras_)
+        {
+            diagnostic_msgs::msg::DiagnosticStatus status;
+            status.name = std::string(this->get_name()) + ": " + camera->image_topic;
+            status.hardware_id = camera->camera_frame;
+            status.level = diagnostic_msgs::msg::DiagnosticStatus::OK;
 
-            if (!marker_ids.empty())
+            const auto add_value = [&status](const std::string &key, double value)
             {
-                // Estimate the pose of the ArUco markers (using solvePnP)
-                std::vector<cv::Vec3d> tvecs;
-                std::vector<cv::Vec3d> rvecs;
+                diagnostic_msgs::msg::KeyValue entry;
+                entry.key = key;
+                entry.value = std::to_string(value);
+                status.values.push_back(std::move(entry));
+            };
+            const auto add_stats = [&](const std::string &name, const RollingStats &stats)
+            {
+                const RollingStats::Summary summary = stats.summary(metrics_scratch_);
+                add_value(name + ".p50", summary.p50);
+                add_value(name + ".p95", summary.p95);
+                add_value(name + ".p99", summary.p99);
+                add_value(name + ".max", summary.max);
+                add_value(name + ".mean", summary.mean);
+                return summary;
+            };
 
-                cv::aruco::estimatePoseSingleMarkers(marker_corners, marker_size_, camera_matrix_, camera_distortion_, rvecs, tvecs);
+            RollingStats::Summary detection;
+            {
+                std::lock_guard<std::mutex> lock(camera->metrics_mutex);
+                const CameraMetrics &metrics = camera->metrics;
+                add_value("window_frames", static_cast<double>(metrics.detection_ms.summary(metrics_scratch_).count));
+                add_stats("input_age_ms", metrics.input_age_ms);
+                add_stats("conversion_ms", metrics.conversion_ms);
+                detection = add_stats("detection_ms", metrics.detection_ms);
+                add_stats("pose_ms", metrics.pose_ms);
+                add_stats("publish_ms", metrics.publish_ms);
+                add_stats("overlay_ms", metrics.overlay_ms);
+                add_stats("latency_ms", metrics.latency_ms);
+                add_stats("markers", metrics.markers);
+                add_stats("rejected_candidates", metrics.rejected_candidates);
+            }
+            add_value("frames_received", static_cast<double>(camera->frames_received.load()));
+            add_value("frames_processed", static_cast<double>(camera->frames_processed.load()));
+            add_value("frames_superseded", static_cast<double>(camera->frames_superseded.load()));
+            add_value("frames_dropped", static_cast<double>(camera->frames_dropped.load()));
+            add_value("frames_skipped", static_cast<double>(camera->frames_skipped.load()));
 
-                if (tvecs.empty() || rvecs.empty())
+            status.message = "detection p95 " + std::to_string(detection.p95) + " ms";
+            if (camera->budget)
+            {
+                add_value("effort_level", camera->budget->level());
+                if (camera->budget->level() == BudgetController::kMaxLevel &&
+                    camera->budget->average_ms() > target_frame_time_ms_)
                 {
-                    RCLCPP_WARN(this->get_logger(), "Pose estimation failed for marker.");
-                    return;
+                    status.level = diagnostic_msgs::msg::DiagnosticStatus::WARN;
+                    status.message = "over the frame-time budget at the lowest detection effort";
                 }
+            }
+            array.status.push_back(std::move(status));
+        }
+        diagnostics_pub_->publish(array);
+    }
 
-                for (size_t i = 0; i < marker_ids.size(); ++i)
-                {
-                    const cv::Vec3d &rvec = rvecs[i]; // Rotation vector for marker i
-                    const cv::Vec3d &tvec = tvecs[i]; // Translation vector for marker i
+    // Each camera has its own conversion, pose and overlay stage threads. The detection stage runs on
+    // `detection_workers` threads shared by all cameras; each worker takes frames from the cameras in
+    // round-robin order, and each camera's pose stage merges the workers' results back into input order.
+    void start_pipeline()
+    {
+        max_reorder_latency_ = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(max_reorder_latency_ms_));
+        for (size_t i = 0; i < detection_workers_; ++i)
+        {
+            worker_events_.push_back(std::make_unique<EventCount>());
+        }
+        for (auto &camera : cameras_)
+        {
+            camera->reorder_buffer = std::make_unique<ReorderBuffer<FrameJobPtr>>(max_reorder_latency_);
+            for (size_t i = 0; i < detection_workers_; ++i)
+            {
+                camera->detection_queues.push_back(std::make_unique<SpscQueue<FrameJobPtr>>(2));
+                camera->result_queues.push_back(std::make_unique<SpscQueue<FrameJobPtr>>(2));
+            }
+        }
 
-                    if (isVec3dZero(tvec))
-                    {
-                        RCLCPP_WARN(this->get_logger(), "tvec is zero");
-                        continue;
-                    }
-                    // Broadcast transform from 'camera_frame' to 'aruco_marker_<id>'
-                    geometry_msgs::msg::TransformStamped marker_transform;
-                    marker_transform.header.stamp = this->get_clock()->now();
-                    marker_transform.header.frame_id = camera_frame_;                                  // Parent frame
-                    marker_transform.child_frame_id = "aruco_marker_" + std::to_string(marker_ids[i]); // Marker-specific frame
-                    marker_transform.transform.translation.x = tvec[0];
-                    marker_transform.transform.translation.y = tvec[1];
-                    marker_transform.transform.translation.z = tvec[2];
-
-                    // RCLCPP_INFO(this->get_logger(), "detected marker: %d", marker_ids[i]);
-                    // logVec3d(tvec, "tvec");
-
-                    tf2::Quaternion quaternion;
-                    cv::Mat rotation_matrix;
-                    cv::Rodrigues(rvec, rotation_matrix); // Convert rvec to a rotation matrix
-                    tf2::Matrix3x3 tf_rotation_matrix(
-                        rotation_matrix.at<double>(0, 0), rotation_matrix.at<double>(0, 1), rotation_matrix.at<double>(0, 2),
-                        rotation_matrix.at<double>(1, 0), rotation_matrix.at<double>(1, 1), rotation_matrix.at<double>(1, 2),
-                        rotation_matrix.at<double>(2, 0), rotation_matrix.at<double>(2, 1), rotation_matrix.at<double>(2, 2));
-                    tf_rotation_matrix.getRotation(quaternion);
-
-                    marker_transform.transform.rotation.x = quaternion.getX();
-                    marker_transform.transform.rotation.y = quaternion.getY();
-                    marker_transform.transform.rotation.z = quaternion.getZ();
-                    marker_transform.transform.rotation.w = quaternion.getW();
-
-                    tf_broadcaster_->sendTransform(marker_transform);
-
-                    // Convert to geometry_msgs::Pose
-                    geometry_msgs::msg::PoseStamped marker_pose;
-                    marker_pose.header.stamp = msg->header.stamp;
-                    marker_pose.header.frame_id = camera_frame_;
-                    marker_pose.pose.position.x = marker_transform.transform.translation.x;
-                    marker_pose.pose.position.y = marker_transform.transform.translation.y;
-                    marker_pose.pose.position.z = marker_transform.transform.translation.z;
-                    marker_pose.pose.orientation.x = marker_transform.transform.rotation.x;
-                    marker_pose.pose.orientation.y = marker_transform.transform.rotation.y;
-                    marker_pose.pose.orientation.z = marker_transform.transform.rotation.z;
-                    marker_pose.pose.orientation.w = marker_transform.transform.rotation.w;
-
-                    // Populate Marker message
-                    aruco_ros2_msgs::msg::Marker marker;
-                    marker.header.frame_id = camera_frame_;
-                    marker.header.stamp = msg->header.stamp;
-                    marker.id = marker_ids[i];
-                    marker.pose = marker_pose;
-                    marker.pixel_x = marker_corners[i][0].x;
-                    marker.pixel_y = marker_corners[i][0].y;
-
-                    // Add marker to array
-                    marker_array.markers.push_back(marker);
-
-                    // Draw 3D axis on the marker in the image
-                    cv::aruco::drawAxis(image, camera_matrix_, camera_distortion_, rvec, tvec, marker_size_ * 0.7f);
-                    draw3dAxis(image, tvec, rvec, 1);
-                }
+        for (auto &camera : cameras_)
+        {
+            pipeline_threads_.emplace_back(&ArucoRos2Node::conversion_stage, this, std::ref(*camera));
+            pipeline_threads_.emplace_back(&ArucoRos2Node::pose_stage, this, std::ref(*camera));
+            pipeline_threads_.emplace_back(&ArucoRos2Node::overlay_stage, this, std::ref(*camera));
+        }
+        for (size_t i = 0; i < detection_workers_; ++i)
+        {
+            pipeline_threads_.emplace_back(&ArucoRos2Node::detection_stage, this, i);
+        }
+    }
 
-                cv::aruco::drawDetectedMarkers(image, marker_corners, marker_ids);
+    void stop_pipeline()
+    {
+        pipeline_running_ = false;
+        for (auto &camera : cameras_)
+        {
+            camera->mailbox.close();
+            camera->results_event.notify();
+            camera->overlay_event.notify();
+        }
+        for (auto &event : worker_events_)
+        {
+            event->notify();
+        }
+        for (auto &thread : pipeline_threads_)
+        {
+            if (thread.joinable())
+            {
+                thread.join();
             }
+        }
+        pipeline_threads_.clear();
+    }
 
-            // Convert OpenCV image back to ROS message
-            auto overlay_msg = cv_bridge::CvImage(msg->header, "bgr8", image).toImageMsg();
-            image_pub_->publish(*overlay_msg);
-
-            // Publish the marker array
-            if (!marker_array.markers.empty())
+    // Stage 1: takes the latest frame from the mailbox and derives the gray image the detector works on
+    void conversion_stage(Camera &camera)
+    {
+        name_trace_thread("conversion " + std::to_string(camera.index));
+        FrameInput input;
+        while (camera.mailbox.take(input))
+        {
+            // Over budget even at reduced effort: process only every n-th frame
+            const int stride = camera.budget ? frameStride(camera.budget->level()) : 1;
+            if (camera.frames_seen++ % stride != 0)
             {
-                marker_array_pub_->publish(marker_array);
+                camera.frames_skipped++;
+                continue;
+            }
+            FrameJobPtr job = acquire_job(camera);
+            job->msg = std::move(input.msg);
+            job->calibration = std::move(input.calibration);
+            job->timings = FrameTimings();
+            job->timings.input_age = input_age_ms(*job->msg);
+            const auto start = std::chrono::steady_clock::now();
+            try
+            {
+                // Wrap the ROS image message without copying it
+                job->cv_image = cv_bridge::toCvShare(job->msg);
+                if (!convertToGray(job->cv_image->image, job->cv_image->encoding, *job))
+                {
+                    job->gray = cv_bridge::cvtColor(job->cv_image, sensor_msgs::image_encodings::MONO8)->image;
+                }
+                job->timings.conversion = elapsed_ms(start);
+            }
+            catch (const cv_bridge::Exception &e)
+            {
+                RCLCPP_ERROR(this->get_logger(), "CV Bridge exception: %s", e.what());
+                camera.frames_dropped++;
+                continue;
+            }
+            job->seq = camera.next_seq++;
+            trace_span(camera, "conversion", *job, start);
+            if (!dispatch_job(camera, std::move(job)))
+            {
+                return;
             }
         }
-        catch (const cv_bridge::Exception &e)
+    }
+
+    // Hands the job to the first detection worker, in round-robin order, that has room for it
+    bool dispatch_job(Camera &camera, FrameJobPtr &&job)
+    {
+        Backoff backoff;
+        while (pipeline_running_)
         {
-            RCLCPP_ERROR(this->get_logger(), "CV Bridge exception: %s", e.what());
+            for (size_t i = 0; i < detection_workers_; ++i)
+            {
+                const size_t worker = (camera.next_worker + i) % detection_workers_;
+                if (camera.detection_queues[worker]->try_push(std::move(job)))
+                {
+                    camera.next_worker = (worker + 1) % detection_workers_;
+                    worker_events_[worker]->notify();
+                    return true;
+                }
+            }
+            backoff.idle();
         }
-        catch (const tf2::TransformException &e)
+        return false;
+    }
+
+    // Stage 2: runs the marker detector (one thread per shared worker). Cameras are served round-robin,
+    // starting after the camera served last, so a busy camera cannot starve the others.
+    void detection_stage(size_t worker)
+    {
+        name_trace_thread("detection " + std::to_string(worker));
+        Snapshot<DetectorConfig>::Reader config(detector_config_);
+        Backoff backoff;
+        size_t next_camera = worker % cameras_.size();
+        FrameJobPtr job;
+        while (pipeline_running_)
         {
-            RCLCPP_WARN(this->get_logger(), "TF2 exception: %s", e.what());
+            bool worked = false;
+            for (size_t i = 0; i < cameras_.size() && !worked; ++i)
+            {
+                const size_t index = (next_camera + i) % cameras_.size();
+                Camera &camera = *cameras_[index];
+                if (!camera.detection_queues[worker]->try_pop(job))
+                {
+                    continue;
+                }
+                next_camera = (index + 1) % cameras_.size();
+                worked = true;
+
+                // Settings changed at runtime take effect here, between frames
+                job->config = config.get();
+                job->effort_level = camera.budget ? camera.budget->level() : 0;
+                const auto start = std::chrono::steady_clock::now();
+                job->full_scan = camera.detector->detect(job->seq, *job->config, job->effort_level, *job);
+                job->timings.detection = elapsed_ms(start);
+                trace_span(camera, "detection", *job, start);
+                if (camera.budget)
+                {
+                    update_budget(camera, job->timings.detection);
+                }
+                if (!push_wait(*camera.result_queues[worker], std::move(job), pipeline_running_))
+                {
+                    return;
+                }
+                camera.results_event.notify();
+            }
+
+            if (worked)
+            {
+                backoff.reset();
+            }
+            else if (!backoff.spin())
+            {
+                // Idle: sleep until a camera dispatches to this worker
+                worker_events_[worker]->wait([&]
+                {
+                    if (!pipeline_running_)
+                    {
+                        return true;
+                    }
+                    for (const auto &camera : cameras_)
+                    {
+                        if (!camera->detection_queues[worker]->empty())
+                        {
+                            return true;
+                        }
+                    }
+                    return false;
+                });
+            }
         }
     }
 
-    void logCvMat(const cv::Mat &mat, const std::string &name = "Matrix")
+    void update_budget(Camera &camera, double elapsed_ms)
     {
-        std::cout << name << " (" << mat.rows << "x" << mat.cols << ", type=" << mat.type() << "):\n";
+        // Skipped frames cost nothing, so the time is spread over every input frame
+        const int level = camera.budget->level();
+        const double detection_ms = elapsed_ms / frameStride(level);
+        if (camera.budget->addSample(detection_ms))
+        {
+            RCLCPP_INFO(this->get_logger(), "%s: detection effort level %d -> %d (%.1f ms per frame, target %.1f ms)",
+                        camera.image_topic.c_str(), level, camera.budget->level(), camera.budget->average_ms(),
+                        target_frame_time_ms_);
+        }
+    }
 
-        for (int i = 0; i < mat.rows; ++i)
+    // Stage 3: collects the workers' results, restores input order, then estimates poses, broadcasts TF
+    // and publishes the marker array, and passes the frame on to the overlay stage if an overlay is due
+    void pose_stage(Camera &camera)
+    {
+        name_trace_thread("pose " + std::to_string(camera.index));
+        Backoff backoff;
+        FrameJobPtr job;
+        while (pipeline_running_)
         {
-            for (int j = 0; j < mat.cols; ++j)
+            const auto now = std::chrono::steady_clock::now();
+            bool received = false;
+            for (auto &queue : camera.result_queues)
             {
-                std::cout << mat.at<double>(i, j) << " ";
+                while (queue->try_pop(job))
+                {
+                    received = true;
+                    if (!camera.reorder_buffer->insert(job->seq, std::move(job), now))
+                    {
+                        // Its slot was skipped after waiting too long; publishing it now would go back in time
+                        camera.frames_dropped++;
+                        recycle_job(camera.pose_recycle_queue, std::move(job));
+                    }
+                }
+            }
+
+            while (camera.reorder_buffer->pop(job, now))
+            {
+                received = true;
+                const rclcpp::Time stamp(job->msg->header.stamp, RCL_ROS_TIME);
+                if (stamp < camera.last_published_stamp)
+                {
+                    camera.frames_dropped++;
+                    recycle_job(camera.pose_recycle_queue, std::move(job));
+                    continue;
+                }
+                camera.last_published_stamp = stamp;
+
+                publish_markers(camera, *job);
+                camera.frames_processed++;
+                record_metrics(camera, *job);
+
+                // The overlay is only rendered when someone is listening and the rate limit allows it. If
+                // the overlay stage is still busy the frame is skipped rather than stalling this stage.
+                if (overlay_due(camera) && camera.overlay_queue.try_push(std::move(job)))
+                {
+                    camera.overlay_event.notify();
+                    continue;
+                }
+                recycle_job(camera.pose_recycle_queue, std::move(job));
+            }
+
+            if (received)
+            {
+                backoff.reset();
+            }
+            else if (!backoff.spin())
+            {
+                // Idle: sleep until a worker delivers a result. Frames held back for a missing one are
+                // released once it is given up on, so then wake up in time for that.
+                const auto ready = [&]
+                {
+                    if (!pipeline_running_)
+                    {
+                        return true;
+                    }
+                    for (const auto &queue : camera.result_queues)
+                    {
+                        if (!queue->empty())
+                        {
+                            return true;
+                        }
+                    }
+                    return false;
+                };
+                if (camera.reorder_buffer->size() > 0)
+                {
+                    camera.results_event.wait_for(ready, max_reorder_latency_);
+                }
+                else
+                {
+                    camera.results_event.wait(ready);
+                }
             }
-            std::cout << "\n";
         }
-        std::cout << std::endl;
     }
 
-    void logVec3d(const cv::Vec3d &vec, const std::string &name = "vec")
+    // Stage 4: renders and publishes the debug overlay
+    void overlay_stage(Camera &camera)
     {
-        std::cout << name << " Vec3d(" << vec[0] << ", " << vec[1] << ", " << vec[2] << ")" << std::endl;
+        name_trace_thread("overlay " + std::to_string(camera.index));
+        FrameJobPtr job;
+        Backoff backoff;
+        while (pipeline_running_)
+        {
+            if (!camera.overlay_queue.try_pop(job))
+            {
+                if (!backoff.spin())
+                {
+                    camera.overlay_event.wait([&]
+                                              { return !pipeline_running_ || !camera.overlay_queue.empty(); });
+                }
+                continue;
+            }
+            backoff.reset();
+            const auto start = std::chrono::steady_clock::now();
+            publish_overlay(camera, *job);
+            trace_span(camera, "overlay", *job, start);
+            {
+                std::lock_guard<std::mutex> lock(camera.metrics_mutex);
+                camera.metrics.overlay_ms.add(elapsed_ms(start));
+            }
+            recycle_job(camera.overlay_recycle_queue, std::move(job));
+        }
     }
 
-    void draw3dAxis(cv::Mat &Image, const cv::Vec3d &tvec, const cv::Vec3d &rvec, int lineSize)
+    // Jobs (and the buffers they own) are recycled back to the conversion stage by whichever stage
+    // touches them last, through one queue per stage so every hand-off stays single-producer
+    FrameJobPtr acquire_job(Camera &camera)
     {
-        float size = marker_size_ * 0.6;
-        cv::Mat objectPoints(4, 3, CV_32FC1);
-
-        // origin
-        objectPoints.at<float>(0, 0) = 0;
-        objectPoints.at<float>(0, 1) = 0;
-        objectPoints.at<float>(0, 2) = 0;
+        FrameJobPtr job;
+        if (camera.pose_recycle_queue.try_pop(job) || camera.overlay_recycle_queue.try_pop(job))
+        {
+            return job;
+        }
+        return std::make_unique<FrameJob>();
+    }
 
-        // (1,0,0)
-        objectPoints.at<float>(1, 0) = size;
-        objectPoints.at<float>(1, 1) = 0;
-        objectPoints.at<float>(1, 2) = 0;
+    void recycle_job(SpscQueue<FrameJobPtr> &queue, FrameJobPtr &&job)
+    {
+        // Release the input frame now instead of when the job is reused
+        job->msg.reset();
+        job->cv_image.reset();
+        job->calibration.reset();
+        job->gray.release();
+        job->marker_ids.clear();
+        job->marker_corners.clear();
+        job->rejected_candidates.clear();
+        job->rvecs.clear();
+        job->tvecs.clear();
+        queue.try_push(std::move(job));
+    }
 
-        // (0,1,0)
-        objectPoints.at<float>(2, 0) = 0;
-        objectPoints.at<float>(2, 1) = size;
-        objectPoints.at<float>(2, 2) = 0;
+    void publish_markers(const Camera &camera, FrameJob &job)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        aruco_ros2_msgs::msg::MarkerArray marker_array;
+        marker_array.header.stamp = this->get_clock()->now();
+        marker_array.header.frame_id = camera.camera_frame;
 
-        // (0,0,1)
-        objectPoints.at<float>(3, 0) = 0;
-        objectPoints.at<float>(3, 1) = 0;
-        objectPoints.at<float>(3, 2) = size;
+        try
+        {
+            if (!job.marker_ids.empty())
+            {
+                // Estimate the pose of all markers at once with the closed-form square solver
+                const auto start = std::chrono::steady_clock::now();
+                solvePoses(*job.calibration, job.config->marker_size, job);
+                job.timings.pose = elapsed_ms(start);
+                trace_span(camera, "pose", job, start);
 
-        std::vector<cv::Point2f> imagePoints;
-        cv::Mat dist_coeffs = cv::Mat::zeros(4, 1, CV_64F);
+                std_msgs::msg::Header header;
+                header.stamp = job.msg->header.stamp;
+                header.frame_id = camera.camera_frame;
+                if (appendMarkers(job, header, marker_array) > 0)
+                {
+                    for (size_t i = 0; i < job.marker_ids.size(); ++i)
+                    {
+                        if (!job.poses.valid[i])
+                        {
+                            RCLCPP_WARN(this->get_logger(), "Pose estimation failed for marker %d", job.marker_ids[i]);
+                        }
+                    }
+                }
 
-        cv::projectPoints(objectPoints, rvec, tvec, camera_matrix_, dist_coeffs, imagePoints);
-        cv::line(Image, imagePoints[0], imagePoints[1], cv::Scalar(0, 0, 255, 255), lineSize);
-        cv::line(Image, imagePoints[0], imagePoints[2], cv::Scalar(0, 255, 0, 255), lineSize);
-        cv::line(Image, imagePoints[0], imagePoints[3], cv::Scalar(255, 0, 0, 255), lineSize);
+                // Broadcast transform from 'camera_frame' to 'aruco_marker_<id>'
+                const builtin_interfaces::msg::Time now = this->get_clock()->now();
+                for (const auto &marker : marker_array.markers)
+                {
+                    tf_broadcaster_->sendTransform(markerTransform(marker, now));
+                }
+            }
 
-        putText(Image, "x", imagePoints[1], cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 255, 255), 2);
-        putText(Image, "y", imagePoints[2], cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0, 255), 2);
-        putText(Image, "z", imagePoints[3], cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 0, 0, 255), 2);
+            // Publish the marker array
+            if (!marker_array.markers.empty())
+            {
+                marker_array_pub_->publish(std::make_unique<aruco_ros2_msgs::msg::MarkerArray>(std::move(marker_array)));
+            }
+        }
+        catch (const tf2::TransformException &e)
+        {
+            RCLCPP_WARN(this->get_logger(), "TF2 exception: %s", e.what());
+        }
+        // TF, message construction and publishing
+        job.timings.publish = elapsed_ms(start) - job.timings.pose;
+        trace_span(camera, "publish", job, start);
     }
 
-    cv::aruco::PREDEFINED_DICTIONARY_NAME dictNameToEnum(const std::string &dict_name)
+    // True when the overlay should be rendered for the current frame: there is at least one subscriber
+    // on /aruco/result and the configured overlay_rate (if any) has elapsed since the last one
+    bool overlay_due(Camera &camera)
     {
-        std::unordered_map<std::string, cv::aruco::PREDEFINED_DICTIONARY_NAME> dict_name_map = {
-            {"DICT_4X4_50", cv::aruco::DICT_4X4_50},
-            {"DICT_4X4_100", cv::aruco::DICT_4X4_100},
-            {"DICT_4X4_250", cv::aruco::DICT_4X4_250},
-            {"DICT_4X4_1000", cv::aruco::DICT_4X4_1000},
-            {"DICT_5X5_50", cv::aruco::DICT_5X5_50},
-            {"DICT_5X5_100", cv::aruco::DICT_5X5_100},
-            {"DICT_5X5_250", cv::aruco::DICT_5X5_250},
-            {"DICT_5X5_1000", cv::aruco::DICT_5X5_1000},
-            {"DICT_6X6_50", cv::aruco::DICT_6X6_50},
-            {"DICT_6X6_100", cv::aruco::DICT_6X6_100},
-            {"DICT_6X6_250", cv::aruco::DICT_6X6_250},
-            {"DICT_6X6_1000", cv::aruco::DICT_6X6_1000},
-            {"DICT_7X7_50", cv::aruco::DICT_7X7_50},
-            {"DICT_7X7_100", cv::aruco::DICT_7X7_100},
-            {"DICT_7X7_250", cv::aruco::DICT_7X7_250},
-            {"DICT_7X7_1000", cv::aruco::DICT_7X7_1000},
-            {"DICT_ARUCO_ORIGINAL", cv::aruco::DICT_ARUCO_ORIGINAL},
-            {"DICT_APRILTAG_16h5", cv::aruco::DICT_APRILTAG_16h5},
-            {"DICT_APRILTAG_25h9", cv::aruco::DICT_APRILTAG_25h9},
-            {"DICT_APRILTAG_36h10", cv::aruco::DICT_APRILTAG_36h10},
-            {"DICT_APRILTAG_36h11", cv::aruco::DICT_APRILTAG_36h11},
-        };
-        if (dict_name_map.find(dict_name) != dict_name_map.end())
+        if (camera.image_pub->get_subscription_count() == 0)
         {
-            return dict_name_map[dict_name];
+            return false;
         }
-        else
+        const auto now = std::chrono::steady_clock::now();
+        if (overlay_rate_ > 0.0 && now - camera.last_overlay_time < std::chrono::duration<double>(1.0 / overlay_rate_))
         {
-            throw std::invalid_argument("Invalid dictionary");
+            return false;
         }
+        camera.last_overlay_time = now;
+        return true;
     }
 
-    bool isVec3dZero(const cv::Vec3d &vec)
+    // Draws the detections on a bgr8 copy of the frame, scaled by overlay_scale, and publishes it on
+    // the camera's result topic. The image is rendered straight into the outgoing message buffer.
+    void publish_overlay(Camera &camera, const FrameJob &job)
     {
-        return vec[0] == 0.0 && vec[1] == 0.0 && vec[2] == 0.0;
+        const cv::Mat &gray = job.gray;
+        const int width = std::max(1, static_cast<int>(std::lround(gray.cols * overlay_scale_)));
+        const int height = std::max(1, static_cast<int>(std::lround(gray.rows * overlay_scale_)));
+
+        auto overlay_msg = std::make_unique<sensor_msgs::msg::Image>();
+        overlay_msg->header = job.msg->header;
+        overlay_msg->height = height;
+        overlay_msg->width = width;
+        overlay_msg->encoding = sensor_msgs::image_encodings::BGR8;
+        overlay_msg->is_bigendian = false;
+        overlay_msg->step = width * 3;
+        overlay_msg->data.resize(overlay_msg->step * height);
+        cv::Mat image(height, width, CV_8UC3, overlay_msg->data.data(), overlay_msg->step);
+
+        renderOverlay(job.cv_image->image, job.cv_image->encoding, job, *job.calibration, job.config->marker_size,
+                      image, camera.overlay_scratch);
+
+        // Publishing the unique_ptr lets intra-process subscribers take ownership without another copy
+        camera.image_pub->publish(std::move(overlay_msg));
     }
 
     // ROS 2 Publisher for ArUco marker info
     rclcpp::Publisher<std_msgs::msg::String>::SharedPtr marker_info_publisher_;
     rclcpp::Publisher<aruco_ros2_msgs::msg::MarkerArray>::SharedPtr marker_array_pub_;
 
-    // Image subscriber (using image_transport)
-    std::unique_ptr<image_transport::ImageTransport> it_;
-    image_transport::Subscriber image_subscriber_;
-
-    // Camera info subscriber
-    rclcpp::Subscription<sensor_msgs::msg::CameraInfo>::SharedPtr camera_info_subscriber_;
-    rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr image_pub_;
-
     // TF broadcaster
     std::shared_ptr<tf2_ros::TransformBroadcaster> tf_broadcaster_;
 
     // ArUco marker detector variables
-    cv::Ptr<cv::aruco::Dictionary> aruco_dict_;
-    cv::Ptr<cv::aruco::DetectorParameters> aruco_parameters_;
-
-    cv::Mat camera_matrix_;
-    cv::Mat camera_distortion_;
-    bool received_camera_info_ = false;
-    double marker_size_;
-    std::string camera_frame_;
-    std::string image_topic_;
-    std::string camera_info_topic_;
-    std::string dictionary_;
+    Snapshot<DetectorConfig> detector_config_;
+    std::string detector_preset_;
+    OnSetParametersCallbackHandle::SharedPtr parameter_callback_;
+#if ARUCO_ROS2_HAS_POST_SET_PARAMETERS_CALLBACK
+    PostSetParametersCallbackHandle::SharedPtr post_parameter_callback_;
+#endif
+
+    // Input cameras, each with its own subscriptions, calibration and pipeline stages
+    std::vector<std::unique_ptr<Camera>> cameras_;
+
+    // Debug overlay settings
+    double overlay_rate_;
+    double overlay_scale_;
+
+    // Pipeline threads. The detection workers are shared by all cameras.
+    std::atomic<bool> pipeline_running_{true};
+    std::vector<std::thread> pipeline_threads_;
+    std::vector<std::unique_ptr<EventCount>> worker_events_; // one per detection worker
+    size_t detection_workers_;
+    double max_reorder_latency_ms_;
+    std::chrono::steady_clock::duration max_reorder_latency_{};
+    int opencv_threads_;
+    double target_frame_time_ms_;
+    bool warmup_;
+    cv::Size warmup_size_;
+
+    // Tracking settings
+    std::string tracking_;
+    TrackingConfig tracking_config_;
+    int full_scan_interval_;
+    double roi_padding_;
+    int klt_verify_interval_;
+
+    rclcpp::TimerBase::SharedPtr stats_timer_;
+
+    // Metrics
+    double metrics_period_;
+    rclcpp::Publisher<diagnostic_msgs::msg::DiagnosticArray>::SharedPtr diagnostics_pub_;
+    rclcpp::TimerBase::SharedPtr metrics_timer_;
+    std::vector<double> metrics_scratch_;
+
+    // Tracing (null when disabled)
+    std::unique_ptr<TraceRecorder> tracer_;
+    std::string trace_file_;
+    rclcpp::Service<std_srvs::srv::Trigger>::SharedPtr dump_trace_service_;
+
     tf2_ros::Buffer tf_buffer_;
     tf2_ros::TransformListener tf_listener_;
 };
 
-int main(int argc, char *argv[])
-{
-    rclcpp::init(argc, argv);
-    auto aruco_node = std::make_shared<ArucoRos2Node>();
-    aruco_node->initialize();
-    rclcpp::spin(aruco_node);
-    rclcpp::shutdown();
-    return 0;
-}
+} // namespace aruco_ros2
+
+RCLCPP_COMPONENTS_REGISTER_NODE(aruco_ros2::ArucoRos2Node)
@@ -0,0 +1,255 @@
+// Writes a synthetic marker corpus: frames rendered by SceneGenerator, ground_truth.csv with the pose and
+// corners of every marker, and camera.yaml with the camera model used, lens distortion included. The same
+// options and seed always produce the same corpus.
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+#include <camera_calibration_parsers/parse.hpp>
+#include <sensor_msgs/msg/camera_info.hpp>
+
+#include "aruco_ros2/synthetic_scene.hpp"
+
+namespace fs = std::filesystem;
+using namespace aruco_ros2;
+
+namespace
+{
+
+void printUsage()
+{
+    std::cerr << "Usage: aruco_scene_gen <output_dir> [options]\n"
+                 "  --frames N               frames to render (default 10)\n"
+                 "  --markers N              markers per frame (default 10)\n"
+                 "  --resolution R           vga, hd, fhd, 4k, 8k or WIDTHxHEIGHT (default vga)\n"
+                 "  --dictionary NAME        aruco dictionary (default DICT_ARUCO_ORIGINAL)\n"
+                 "  --distortion MODEL:D     lens distortion as a CameraInfo model and its coefficients, e.g.\n"
+                 "                           plumb_bob:-0.3,0.1,0,0,0 or equidistant:0.1,-0.05,0.01,0\n"
+                 "                           (default: ideal pinhole)\n"
+                 "  --marker-size M          marker side in meters (default 0.1)\n"
+                 "  --fill F                 fraction of its grid cell a marker covers (default 0.6)\n"
+                 "  --max-tilt DEG           maximum marker tilt (default 45)\n"
+                 "  --blur SIGMA             Gaussian blur in pixels (default 0)\n"
+                 "  --noise SIGMA            Gaussian noise in gray levels (default 0)\n"
+                 "  --lighting L             brightness falloff across the image, 0..1 (default 0)\n"
+                 "  --clutter N              distractor shapes per frame (default 0)\n"
+                 "  --mono                   write mono8 instead of bgr8 frames\n"
+                 "  --seed N                 random seed (default 1)\n";
+}
+
+// MODEL:K1,K2,... with as many coefficients as the model takes (plumb_bob 4 or 5, rational_polynomial 8,
+// equidistant 4)
+void parseDistortion(const std::string &text, DistortionModel &model, cv::Mat &coefficients)
+{
+    const size_t colon = text.find(':');
+    if (colon == std::string::npos || !parseDistortionModel(text.substr(0, colon), model))
+    {
+        throw std::invalid_argument("invalid distortion " + text);
+    }
+    std::vector<double> values;
+    std::stringstream list(text.substr(colon + 1));
+    std::string value;
+    while (std::getline(list, value, ','))
+    {
+        values.push_back(std::stod(value));
+    }
+    const size_t count = values.size();
+    bool valid = false;
+    switch (model)
+    {
+    case DistortionModel::PlumbBob:
+        valid = count == 4 || count == 5;
+        break;
+    case DistortionModel::RationalPolynomial:
+        valid = count == 8;
+        break;
+    case DistortionModel::Equidistant:
+        valid = count == 4;
+        break;
+    }
+    if (!valid)
+    {
+        throw std::invalid_argument(std::string("wrong number of coefficients for ") + distortionModelName(model));
+    }
+    coefficients = cv::Mat(values, true).reshape(1, 1);
+}
+
+bool parseOptions(int argc, char **argv, std::string &output_dir, int &frames, SceneConfig &config,
+                  DistortionModel &model, cv::Mat &distortion)
+{
+    std::vector<std::string> args(argv + 1, argv + argc);
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        const std::string &arg = args[i];
+        const auto value = [&]() -> const std::string &
+        {
+            if (i + 1 >= args.size())
+            {
+                throw std::invalid_argument("missing value for " + arg);
+            }
+            return args[++i];
+        };
+        if (arg == "--help" || arg == "-h")
+        {
+            return false;
+        }
+        else if (arg == "--frames")
+        {
+            frames = std::stoi(value());
+        }
+        else if (arg == "--markers")
+        {
+            config.marker_count = std::stoi(value());
+        }
+        else if (arg == "--resolution")
+        {
+            if (!parseResolution(value(), config.image_size))
+            {
+                throw std::invalid_argument("invalid resolution " + args[i]);
+            }
+        }
+        else if (arg == "--dictionary")
+        {
+            config.dictionary_name = value();
+        }
+        else if (arg == "--distortion")
+        {
+            parseDistortion(value(), model, distortion);
+        }
+        else if (arg == "--marker-size")
+        {
+            config.marker_size = std::stod(value());
+        }
+        else if (arg == "--fill")
+        {
+            config.fill = std::stod(value());
+        }
+        else if (arg == "--max-tilt")
+        {
+            config.max_tilt_deg = std::stod(value());
+        }
+        else if (arg == "--blur")
+        {
+            config.blur_sigma = std::stod(value());
+        }
+        else if (arg == "--noise")
+        {
+            config.noise_sigma = std::stod(value());
+        }
+        else if (arg == "--lighting")
+        {
+            config.lighting = std::stod(value());
+        }
+        else if (arg == "--clutter")
+        {
+            config.clutter = std::stoi(value());
+        }
+        else if (arg == "--mono")
+        {
+            config.color = false;
+        }
+        else if (arg == "--seed")
+        {
+            config.seed = std::stoull(value());
+        }
+        else if (!arg.empty() && arg[0] != '-' && output_dir.empty())
+        {
+            output_dir = arg;
+        }
+        else
+        {
+            throw std::invalid_argument("unknown argument " + arg);
+        }
+    }
+    return !output_dir.empty();
+}
+
+bool writeCameraInfo(const std::string &file, const CameraCalibration &calibration)
+{
+    sensor_msgs::msg::CameraInfo info;
+    info.width = calibration.imageSize().width;
+    info.height = calibration.imageSize().height;
+    info.distortion_model = distortionModelName(calibration.model());
+    const cv::Mat &d = calibration.distortion();
+    info.d.assign(d.ptr<double>(), d.ptr<double>() + d.total());
+    const cv::Mat &k = calibration.cameraMatrix();
+    for (int i = 0; i < 9; ++i)
+    {
+        info.k[i] = k.at<double>(i / 3, i % 3);
+    }
+    info.r = {1, 0, 0, 0, 1, 0, 0, 0, 1};
+    info.p = {info.k[0], info.k[1], info.k[2], 0, info.k[3], info.k[4], info.k[5], 0, 0, 0, 1, 0};
+    return camera_calibration_parsers::writeCalibration(file, "synthetic", info);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    std::string output_dir;
+    int frames = 10;
+    SceneConfig config;
+    config.marker_count = 10;
+    DistortionModel model = DistortionModel::PlumbBob;
+    cv::Mat distortion;
+    try
+    {
+        if (!parseOptions(argc, argv, output_dir, frames, config, model, distortion))
+        {
+            printUsage();
+            return 1;
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "aruco_scene_gen: " << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    try
+    {
+        SceneGenerator generator(config, makePinholeCalibration(config.image_size, distortion, model));
+        fs::create_directories(output_dir);
+        if (!writeCameraInfo((fs::path(output_dir) / "camera.yaml").string(), generator.calibration()))
+        {
+            throw std::runtime_error("could not write camera.yaml");
+        }
+        std::ofstream truth(fs::path(output_dir) / "ground_truth.csv");
+        if (!truth)
+        {
+            throw std::runtime_error("could not write ground_truth.csv");
+        }
+        writeGroundTruthHeader(truth);
+
+        cv::Mat image;
+        std::vector<SceneMarker> markers;
+        size_t placed = 0;
+        for (int frame = 0; frame < frames; ++frame)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%06d.png", frame);
+            generator.render(image, markers);
+            if (!cv::imwrite((fs::path(output_dir) / name).string(), image))
+            {
+                throw std::runtime_error(std::string("could not write ") + name);
+            }
+            writeGroundTruth(truth, name, markers);
+            placed += markers.size();
+        }
+        std::cout << "Wrote " << frames << " frames of " << config.image_size.width << "x" << config.image_size.height
+                  << " with " << placed << " markers to " << output_dir << "\n";
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "aruco_scene_gen: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include "aruco_ros2/budget_controller.hpp"
+
+#include <algorithm>
+
+namespace aruco_ros2
+{
+
+BudgetController::BudgetController(const BudgetControllerConfig &config) : config_(config)
+{
+}
+
+bool BudgetController::addSample(double detection_ms)
+{
+    std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+        return false;
+    }
+
+    average_ms_ = have_average_ ? average_ms_ + config_.smoothing * (detection_ms - average_ms_) : detection_ms;
+    have_average_ = true;
+    ++frames_since_change_;
+
+    int level = level_.load(std::memory_order_relaxed);
+    if (average_ms_ > config_.target_ms && level < kMaxLevel && frames_since_change_ >= config_.lower_hold_frames)
+    {
+        ++level;
+    }
+    else if (average_ms_ < config_.relax_ratio * config_.target_ms && level > 0 &&
+             frames_since_change_ >= config_.raise_hold_frames)
+    {
+        --level;
+    }
+    else
+    {
+        return false;
+    }
+    level_.store(level, std::memory_order_relaxed);
+    frames_since_change_ = 0;
+    return true;
+}
+
+double BudgetController::average_ms() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return average_ms_;
+}
+
+void applyEffortLevel(int level, cv::aruco::DetectorParameters &params, int &pyramid_level)
+{
+    if (level >= 1)
+    {
+        params.adaptiveThreshWinSizeStep *= 2;
+    }
+    if (level >= 2)
+    {
+        const int middle = (params.adaptiveThreshWinSizeMin + params.adaptiveThreshWinSizeMax) / 2;
+        params.adaptiveThreshWinSizeMin = middle;
+        params.adaptiveThreshWinSizeMax = middle;
+        params.minMarkerPerimeterRate = std::min(params.minMarkerPerimeterRate * 2.0, params.maxMarkerPerimeterRate / 2.0);
+    }
+    if (level >= 3)
+    {
+        pyramid_level = std::min(pyramid_level + 1, 4);
+    }
+    if (level >= 4)
+    {
+        pyramid_level = std::min(pyramid_level + 1, 4);
+        params.minMarkerPerimeterRate = std::min(params.minMarkerPerimeterRate * 2.0, params.maxMarkerPerimeterRate / 2.0);
+    }
+}
+
+int frameStride(int level)
+{
+    return level >= 6 ? 3 : level >= 5 ? 2 : 1;
+}
+
+} // namespace aruco_ros2
@@ -0,0 +1,220 @@
+#include "aruco_ros2/camera_calibration.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include <opencv2/calib3d.hpp>
+
+namespace aruco_ros2
+{
+
+namespace
+{
+bool sameValues(const cv::Mat &a, const cv::Mat &b)
+{
+    return a.total() == b.total() && (a.empty() || cv::norm(a.reshape(1, 1), b.reshape(1, 1), cv::NORM_INF) == 0.0);
+}
+
+// Distortion coefficients as one CV_64F row; an empty Mat (no D in the calibration) means none
+cv::Mat distortionRow(const cv::Mat &distortion)
+{
+    if (distortion.empty())
+    {
+        return cv::Mat::zeros(1, 5, CV_64F);
+    }
+    cv::Mat row;
+    distortion.reshape(1, 1).convertTo(row, CV_64F);
+    return row;
+}
+
+// The fisheye functions take exactly four coefficients
+cv::Mat fisheyeCoefficients(const cv::Mat &distortion)
+{
+    cv::Mat coefficients = cv::Mat::zeros(1, 4, CV_64F);
+    for (int i = 0; i < std::min(4, distortion.cols); ++i)
+    {
+        coefficients.at<double>(0, i) = distortion.at<double>(0, i);
+    }
+    return coefficients;
+}
+} // namespace
+
+bool parseDistortionModel(const std::string &name, DistortionModel &model)
+{
+    // Names as in sensor_msgs/distortion_models.hpp; "fisheye" is what some drivers publish instead
+    if (name.empty() || name == "plumb_bob")
+    {
+        model = DistortionModel::PlumbBob;
+    }
+    else if (name == "rational_polynomial")
+    {
+        model = DistortionModel::RationalPolynomial;
+    }
+    else if (name == "equidistant" || name == "fisheye")
+    {
+        model = DistortionModel::Equidistant;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+const char *distortionModelName(DistortionModel model)
+{
+    switch (model)
+    {
+    case DistortionModel::RationalPolynomial:
+        return "rational_polynomial";
+    case DistortionModel::Equidistant:
+        return "equidistant";
+    default:
+        return "plumb_bob";
+    }
+}
+
+CameraCalibration::CameraCalibration(const cv::Size &image_size, const cv::Mat &camera_matrix,
+                                     const cv::Mat &distortion, DistortionModel model)
+    : image_size_(image_size), model_(model)
+{
+    camera_matrix.convertTo(camera_matrix_, CV_64F);
+    distortion_ = distortionRow(distortion);
+    if (model_ == DistortionModel::Equidistant)
+    {
+        distortion_ = fisheyeCoefficients(distortion_);
+    }
+
+    fx_ = camera_matrix_.at<double>(0, 0);
+    fy_ = camera_matrix_.at<double>(1, 1);
+    cx_ = camera_matrix_.at<double>(0, 2);
+    cy_ = camera_matrix_.at<double>(1, 2);
+    skew_ = camera_matrix_.at<double>(0, 1);
+
+    // An equidistant lens is not a pinhole even with all coefficients zero
+    has_distortion_ = model_ == DistortionModel::Equidistant || cv::countNonZero(distortion_) > 0;
+    if (has_distortion_ && image_size_.width > 0 && image_size_.height > 0)
+    {
+        buildTable();
+    }
+}
+
+bool CameraCalibration::matches(const cv::Size &image_size, const cv::Mat &camera_matrix,
+                                const cv::Mat &distortion, DistortionModel model) const
+{
+    if (model != model_ || image_size != image_size_ || !sameValues(camera_matrix, camera_matrix_))
+    {
+        return false;
+    }
+    if (model_ == DistortionModel::Equidistant)
+    {
+        return sameValues(fisheyeCoefficients(distortionRow(distortion)), distortion_);
+    }
+    return sameValues(distortionRow(distortion), distortion_);
+}
+
+void CameraCalibration::buildTable()
+{
+    table_cols_ = (image_size_.width - 1) / kTableStep + 2;
+    table_rows_ = (image_size_.height - 1) / kTableStep + 2;
+
+    std::vector<cv::Point2f> nodes;
+    nodes.reserve(static_cast<size_t>(table_cols_) * table_rows_);
+    for (int r = 0; r < table_rows_; ++r)
+    {
+        for (int c = 0; c < table_cols_; ++c)
+        {
+            nodes.emplace_back(static_cast<float>(c * kTableStep), static_cast<float>(r * kTableStep));
+        }
+    }
+    if (model_ == DistortionModel::Equidistant)
+    {
+        cv::fisheye::undistortPoints(nodes, table_, camera_matrix_, distortion_);
+    }
+    else
+    {
+        // The default of five iterations is not enough near the borders of strongly distorted lenses;
+        // the table is built once, so iterate to convergence
+        cv::undistortPoints(nodes, table_, camera_matrix_, distortion_, cv::noArray(), cv::noArray(),
+                            cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 100, 1e-10));
+    }
+}
+
+void CameraCalibration::undistortExact(const std::vector<cv::Point2f> &pixels,
+                                       std::vector<cv::Point2f> &normalized) const
+{
+    if (model_ == DistortionModel::Equidistant)
+    {
+        cv::fisheye::undistortPoints(pixels, normalized, camera_matrix_, distortion_);
+    }
+    else
+    {
+        cv::undistortPoints(pixels, normalized, camera_matrix_, distortion_);
+    }
+}
+
+void CameraCalibration::undistort(const std::vector<cv::Point2f> &pixels, std::vector<cv::Point2f> &normalized) const
+{
+    normalized.resize(pixels.size());
+
+    if (!has_distortion_)
+    {
+        for (size_t i = 0; i < pixels.size(); ++i)
+        {
+            const double y = (pixels[i].y - cy_) / fy_;
+            const double x = (pixels[i].x - cx_ - skew_ * y) / fx_;
+            normalized[i] = cv::Point2f(static_cast<float>(x), static_cast<float>(y));
+        }
+        return;
+    }
+    if (table_.empty())
+    {
+        // No image size in the calibration
+        undistortExact(pixels, normalized);
+        return;
+    }
+
+    const float max_x = static_cast<float>((table_cols_ - 1) * kTableStep);
+    const float max_y = static_cast<float>((table_rows_ - 1) * kTableStep);
+    for (size_t i = 0; i < pixels.size(); ++i)
+    {
+        const cv::Point2f &p = pixels[i];
+        if (!(p.x >= 0.0f && p.y >= 0.0f && p.x <= max_x && p.y <= max_y))
+        {
+            // A corner outside the image
+            std::vector<cv::Point2f> in{p}, out;
+            undistortExact(in, out);
+            normalized[i] = out[0];
+            continue;
+        }
+        const float fx = p.x / kTableStep;
+        const float fy = p.y / kTableStep;
+        const int c = std::min(static_cast<int>(fx), table_cols_ - 2);
+        const int r = std::min(static_cast<int>(fy), table_rows_ - 2);
+        const float ax = fx - c;
+        const float ay = fy - r;
+
+        const cv::Point2f *row0 = &table_[static_cast<size_t>(r) * table_cols_ + c];
+        const cv::Point2f *row1 = row0 + table_cols_;
+        const cv::Point2f top = row0[0] + (row0[1] - row0[0]) * ax;
+        const cv::Point2f bottom = row1[0] + (row1[1] - row1[0]) * ax;
+        normalized[i] = top + (bottom - top) * ay;
+    }
+}
+
+void CameraCalibration::project(const std::vector<cv::Point3f> &object_points, const cv::Vec3d &rvec,
+                                const cv::Vec3d &tvec, const cv::Mat &camera_matrix,
+                                std::vector<cv::Point2f> &image_points) const
+{
+    const cv::Mat &k = camera_matrix.empty() ? camera_matrix_ : camera_matrix;
+    if (model_ == DistortionModel::Equidistant)
+    {
+        cv::fisheye::projectPoints(object_points, image_points, rvec, tvec, k, distortion_);
+    }
+    else
+    {
+        cv::projectPoints(object_points, rvec, tvec, k, distortion_, image_points);
+    }
+}
+
+} // namespace aruco_ros2
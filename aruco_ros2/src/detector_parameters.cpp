@@ -0,0 +1,103 @@
+#include "aruco_ros2/detector_parameters.hpp"
+
+namespace aruco_ros2
+{
+
+std::vector<std::string> detectorPresetNames()
+{
+    return {"default", "fast", "balanced", "accurate"};
+}
+
+bool applyDetectorPreset(const std::string &name, cv::aruco::DetectorParameters &params)
+{
+    params = *cv::aruco::DetectorParameters::create();
+
+    if (name == "default" || name.empty())
+    {
+        return true;
+    }
+    if (name == "fast")
+    {
+        // Thresholding at each window scale is a full pass over the image; one scale is usually
+        // enough for well-lit markers of reasonable size
+        params.adaptiveThreshWinSizeMin = 7;
+        params.adaptiveThreshWinSizeMax = 7;
+        params.adaptiveThreshWinSizeStep = 10;
+        params.minMarkerPerimeterRate = 0.1;
+        params.polygonalApproxAccuracyRate = 0.05;
+        params.perspectiveRemovePixelPerCell = 2;
+        params.cornerRefinementMethod = cv::aruco::CORNER_REFINE_NONE;
+        return true;
+    }
+    if (name == "balanced")
+    {
+        params.adaptiveThreshWinSizeMin = 5;
+        params.adaptiveThreshWinSizeMax = 15;
+        params.adaptiveThreshWinSizeStep = 10;
+        params.minMarkerPerimeterRate = 0.05;
+        params.cornerRefinementMethod = cv::aruco::CORNER_REFINE_SUBPIX;
+        return true;
+    }
+    if (name == "accurate")
+    {
+        params.adaptiveThreshWinSizeMin = 3;
+        params.adaptiveThreshWinSizeMax = 33;
+        params.adaptiveThreshWinSizeStep = 5;
+        params.minMarkerPerimeterRate = 0.01;
+        params.perspectiveRemovePixelPerCell = 8;
+        params.cornerRefinementMethod = cv::aruco::CORNER_REFINE_SUBPIX;
+        params.cornerRefinementMaxIterations = 50;
+        params.cornerRefinementMinAccuracy = 0.01;
+        return true;
+    }
+    return false;
+}
+
+bool validateDetectorParameters(const cv::aruco::DetectorParameters &params, std::string &error)
+{
+    if (params.adaptiveThreshWinSizeMin < 3 || params.adaptiveThreshWinSizeMax < 3)
+    {
+        error = "adaptiveThreshWinSizeMin and adaptiveThreshWinSizeMax must be at least 3";
+    }
+    else if (params.adaptiveThreshWinSizeMax < params.adaptiveThreshWinSizeMin)
+    {
+        error = "adaptiveThreshWinSizeMax must not be below adaptiveThreshWinSizeMin";
+    }
+    else if (params.adaptiveThreshWinSizeStep <= 0)
+    {
+        error = "adaptiveThreshWinSizeStep must be positive";
+    }
+    else if (params.minMarkerPerimeterRate <= 0 || params.maxMarkerPerimeterRate <= params.minMarkerPerimeterRate)
+    {
+        error = "marker perimeter rates must satisfy 0 < minMarkerPerimeterRate < maxMarkerPerimeterRate";
+    }
+    else if (params.polygonalApproxAccuracyRate <= 0)
+    {
+        error = "polygonalApproxAccuracyRate must be positive";
+    }
+    else if (params.cornerRefinementMethod < cv::aruco::CORNER_REFINE_NONE ||
+             params.cornerRefinementMethod > cv::aruco::CORNER_REFINE_APRILTAG)
+    {
+        error = "cornerRefinementMethod must be 0 (none), 1 (subpix), 2 (contour) or 3 (apriltag)";
+    }
+    else if (params.cornerRefinementWinSize < 1 || params.cornerRefinementMaxIterations < 1 ||
+             params.cornerRefinementMinAccuracy <= 0)
+    {
+        error = "corner refinement window, iterations and accuracy must be positive";
+    }
+    else if (params.markerBorderBits < 1 || params.perspectiveRemovePixelPerCell < 1)
+    {
+        error = "markerBorderBits and perspectiveRemovePixelPerCell must be at least 1";
+    }
+    else if (params.errorCorrectionRate < 0)
+    {
+        error = "errorCorrectionRate must not be negative";
+    }
+    else
+    {
+        return true;
+    }
+    return false;
+}
+
+} // namespace aruco_ros2
@@ -0,0 +1,343 @@
+#include "aruco_ros2/frame_processing.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <opencv2/imgproc.hpp>
+
+#include "aruco_ros2/budget_controller.hpp"
+
+namespace aruco_ros2
+{
+
+namespace
+{
+
+bool isVec3dZero(const cv::Vec3d &vec)
+{
+    return vec[0] == 0.0 && vec[1] == 0.0 && vec[2] == 0.0;
+}
+
+// Same as cv::aruco::drawAxis, but projected with the camera's own lens model so that it also
+// lines up on equidistant (fisheye) images
+void drawAxis(cv::Mat &image, const CameraCalibration &calibration, const cv::Mat &camera_matrix,
+              const cv::Vec3d &rvec, const cv::Vec3d &tvec, float length)
+{
+    const std::vector<cv::Point3f> axis_points{{0, 0, 0}, {length, 0, 0}, {0, length, 0}, {0, 0, length}};
+    std::vector<cv::Point2f> image_points;
+    calibration.project(axis_points, rvec, tvec, camera_matrix, image_points);
+    cv::line(image, image_points[0], image_points[1], cv::Scalar(0, 0, 255), 3);
+    cv::line(image, image_points[0], image_points[2], cv::Scalar(0, 255, 0), 3);
+    cv::line(image, image_points[0], image_points[3], cv::Scalar(255, 0, 0), 3);
+}
+
+void draw3dAxis(cv::Mat &Image, const CameraCalibration &calibration, const cv::Mat &camera_matrix, double marker_size, const cv::Vec3d &tvec, const cv::Vec3d &rvec, int lineSize)
+{
+    float size = marker_size * 0.6;
+    const std::vector<cv::Point3f> objectPoints{
+        {0, 0, 0},    // origin
+        {size, 0, 0}, // (1,0,0)
+        {0, size, 0}, // (0,1,0)
+        {0, 0, size}, // (0,0,1)
+    };
+
+    std::vector<cv::Point2f> imagePoints;
+    calibration.project(objectPoints, rvec, tvec, camera_matrix, imagePoints);
+    cv::line(Image, imagePoints[0], imagePoints[1], cv::Scalar(0, 0, 255, 255), lineSize);
+    cv::line(Image, imagePoints[0], imagePoints[2], cv::Scalar(0, 255, 0, 255), lineSize);
+    cv::line(Image, imagePoints[0], imagePoints[3], cv::Scalar(255, 0, 0, 255), lineSize);
+
+    putText(Image, "x", imagePoints[1], cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 0, 255, 255), 2);
+    putText(Image, "y", imagePoints[2], cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(0, 255, 0, 255), 2);
+    putText(Image, "z", imagePoints[3], cv::FONT_HERSHEY_SIMPLEX, 0.6, cv::Scalar(255, 0, 0, 255), 2);
+}
+
+// Renders the bgr8 base of the overlay into `dst`, resizing to its size when needed, without
+// touching the (possibly shared, read-only) input frame
+void renderOverlayBase(const cv::Mat &image, const std::string &encoding, const cv::Mat &gray, cv::Mat &dst, cv::Mat &scratch)
+{
+    cv::Mat source = image;
+    int code = -1;
+    if (encoding == "rgb8")
+    {
+        code = cv::COLOR_RGB2BGR;
+    }
+    else if (encoding == "bgra8")
+    {
+        code = cv::COLOR_BGRA2BGR;
+    }
+    else if (encoding == "rgba8")
+    {
+        code = cv::COLOR_RGBA2BGR;
+    }
+    else if (encoding != "bgr8")
+    {
+        source = gray;
+        code = cv::COLOR_GRAY2BGR;
+    }
+
+    if (source.size() != dst.size())
+    {
+        cv::resize(source, scratch, dst.size(), 0, 0, cv::INTER_AREA);
+        source = scratch;
+    }
+    if (code < 0)
+    {
+        source.copyTo(dst);
+    }
+    else
+    {
+        cv::cvtColor(source, dst, code);
+    }
+}
+
+} // namespace
+
+cv::aruco::PREDEFINED_DICTIONARY_NAME dictNameToEnum(const std::string &dict_name)
+{
+    static const std::unordered_map<std::string, cv::aruco::PREDEFINED_DICTIONARY_NAME> dict_name_map = {
+        {"DICT_4X4_50", cv::aruco::DICT_4X4_50},
+        {"DICT_4X4_100", cv::aruco::DICT_4X4_100},
+        {"DICT_4X4_250", cv::aruco::DICT_4X4_250},
+        {"DICT_4X4_1000", cv::aruco::DICT_4X4_1000},
+        {"DICT_5X5_50", cv::aruco::DICT_5X5_50},
+        {"DICT_5X5_100", cv::aruco::DICT_5X5_100},
+        {"DICT_5X5_250", cv::aruco::DICT_5X5_250},
+        {"DICT_5X5_1000", cv::aruco::DICT_5X5_1000},
+        {"DICT_6X6_50", cv::aruco::DICT_6X6_50},
+        {"DICT_6X6_100", cv::aruco::DICT_6X6_100},
+        {"DICT_6X6_250", cv::aruco::DICT_6X6_250},
+        {"DICT_6X6_1000", cv::aruco::DICT_6X6_1000},
+        {"DICT_7X7_50", cv::aruco::DICT_7X7_50},
+        {"DICT_7X7_100", cv::aruco::DICT_7X7_100},
+        {"DICT_7X7_250", cv::aruco::DICT_7X7_250},
+        {"DICT_7X7_1000", cv::aruco::DICT_7X7_1000},
+        {"DICT_ARUCO_ORIGINAL", cv::aruco::DICT_ARUCO_ORIGINAL},
+        {"DICT_APRILTAG_16h5", cv::aruco::DICT_APRILTAG_16h5},
+        {"DICT_APRILTAG_25h9", cv::aruco::DICT_APRILTAG_25h9},
+        {"DICT_APRILTAG_36h10", cv::aruco::DICT_APRILTAG_36h10},
+        {"DICT_APRILTAG_36h11", cv::aruco::DICT_APRILTAG_36h11},
+    };
+    const auto it = dict_name_map.find(dict_name);
+    if (it == dict_name_map.end())
+    {
+        throw std::invalid_argument("Invalid dictionary");
+    }
+    return it->second;
+}
+
+bool convertToGray(const cv::Mat &image, const std::string &encoding, FrameState &state)
+{
+    if (encoding == "mono8")
+    {
+        state.gray = image;
+        return true;
+    }
+    if (encoding == "bgr8")
+    {
+        cv::cvtColor(image, state.gray_buffer, cv::COLOR_BGR2GRAY);
+    }
+    else if (encoding == "rgb8")
+    {
+        cv::cvtColor(image, state.gray_buffer, cv::COLOR_RGB2GRAY);
+    }
+    else if (encoding == "bgra8")
+    {
+        cv::cvtColor(image, state.gray_buffer, cv::COLOR_BGRA2GRAY);
+    }
+    else if (encoding == "rgba8")
+    {
+        cv::cvtColor(image, state.gray_buffer, cv::COLOR_RGBA2GRAY);
+    }
+    else
+    {
+        return false;
+    }
+    state.gray = state.gray_buffer;
+    return true;
+}
+
+void resolveDetectorSettings(const DetectorConfig &config, int effort_level, FrameState &state)
+{
+    state.pyramid_level = config.pyramid_level;
+    if (effort_level == 0)
+    {
+        state.parameters = config.parameters;
+        return;
+    }
+    if (!state.effort_parameters)
+    {
+        state.effort_parameters = cv::makePtr<cv::aruco::DetectorParameters>();
+    }
+    *state.effort_parameters = *config.parameters;
+    applyEffortLevel(effort_level, *state.effort_parameters, state.pyramid_level);
+    state.parameters = state.effort_parameters;
+}
+
+void detectFullFrame(const DetectorConfig &config, FrameState &state)
+{
+    if (state.pyramid_level == 0)
+    {
+        cv::aruco::detectMarkers(state.gray, config.dictionary, state.marker_corners, state.marker_ids, state.parameters, state.rejected_candidates);
+        return;
+    }
+
+    const int scale = 1 << state.pyramid_level;
+    const cv::Size coarse_size(std::max(1, state.gray.cols / scale), std::max(1, state.gray.rows / scale));
+    cv::resize(state.gray, state.coarse_buffer, coarse_size, 0, 0, cv::INTER_AREA);
+    cv::aruco::detectMarkers(state.coarse_buffer, config.dictionary, state.marker_corners, state.marker_ids, state.parameters, state.rejected_candidates);
+
+    // Map pixel centers back to full resolution
+    const float sx = static_cast<float>(state.gray.cols) / coarse_size.width;
+    const float sy = static_cast<float>(state.gray.rows) / coarse_size.height;
+    const auto upscale = [sx, sy](std::vector<std::vector<cv::Point2f>> &quads)
+    {
+        for (auto &quad : quads)
+        {
+            for (auto &corner : quad)
+            {
+                corner.x = (corner.x + 0.5f) * sx - 0.5f;
+                corner.y = (corner.y + 0.5f) * sy - 0.5f;
+            }
+        }
+    };
+    upscale(state.marker_corners);
+    upscale(state.rejected_candidates);
+
+    if (state.marker_corners.empty())
+    {
+        return;
+    }
+
+    // The coarse corners can be off by about one coarse pixel, so the search window has to cover that
+    state.refine_points.clear();
+    for (const auto &quad : state.marker_corners)
+    {
+        state.refine_points.insert(state.refine_points.end(), quad.begin(), quad.end());
+    }
+    const int half_window = scale + 2;
+    cv::cornerSubPix(state.gray, state.refine_points, cv::Size(half_window, half_window), cv::Size(-1, -1),
+                     cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 30, 0.01));
+    for (size_t i = 0; i < state.marker_corners.size(); ++i)
+    {
+        std::copy_n(state.refine_points.begin() + i * 4, 4, state.marker_corners[i].begin());
+    }
+}
+
+void detectInRois(const DetectorConfig &config, FrameState &state)
+{
+    state.marker_ids.clear();
+    state.marker_corners.clear();
+    state.rejected_candidates.clear();
+
+    for (const cv::Rect &roi : state.rois)
+    {
+        cv::aruco::detectMarkers(state.gray(roi), config.dictionary, state.roi_corners, state.roi_ids, state.parameters, state.roi_rejected);
+
+        const cv::Point2f offset(static_cast<float>(roi.x), static_cast<float>(roi.y));
+        for (size_t i = 0; i < state.roi_ids.size(); ++i)
+        {
+            for (auto &corner : state.roi_corners[i])
+            {
+                corner += offset;
+            }
+            state.marker_ids.push_back(state.roi_ids[i]);
+            state.marker_corners.push_back(state.roi_corners[i]);
+        }
+        for (auto &candidate : state.roi_rejected)
+        {
+            for (auto &corner : candidate)
+            {
+                corner += offset;
+            }
+            state.rejected_candidates.push_back(candidate);
+        }
+    }
+}
+
+void solvePoses(const CameraCalibration &calibration, double marker_size, FrameState &state)
+{
+    const size_t count = state.marker_corners.size();
+    state.pixel_corners.clear();
+    for (const auto &marker : state.marker_corners)
+    {
+        state.pixel_corners.insert(state.pixel_corners.end(), marker.begin(), marker.end());
+    }
+    calibration.undistort(state.pixel_corners, state.normalized_corners);
+
+    SquarePoseBatch &poses = state.poses;
+    poses.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (size_t k = 0; k < 4; ++k)
+        {
+            poses.u[k][i] = state.normalized_corners[i * 4 + k].x;
+            poses.v[k][i] = state.normalized_corners[i * 4 + k].y;
+        }
+    }
+    solveSquarePoses(poses, marker_size);
+
+    state.rvecs.resize(count);
+    state.tvecs.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!poses.valid[i])
+        {
+            state.rvecs[i] = cv::Vec3d();
+            state.tvecs[i] = cv::Vec3d();
+            continue;
+        }
+        quaternionToRotationVector(poses.qx[i], poses.qy[i], poses.qz[i], poses.qw[i], state.rvecs[i].val);
+        state.tvecs[i] = cv::Vec3d(poses.tx[i], poses.ty[i], poses.tz[i]);
+    }
+}
+
+void renderOverlay(const cv::Mat &image, const std::string &encoding, const FrameState &state,
+                   const CameraCalibration &calibration, double marker_size, cv::Mat &dst, cv::Mat &scratch)
+{
+    const cv::Mat &gray = state.gray;
+    const int width = dst.cols;
+    const int height = dst.rows;
+    renderOverlayBase(image, encoding, gray, dst, scratch);
+
+    // Intrinsics and corners are scaled to match the overlay resolution
+    cv::Mat camera_matrix = calibration.cameraMatrix();
+    std::vector<std::vector<cv::Point2f>> corners = state.marker_corners;
+    if (width != gray.cols || height != gray.rows)
+    {
+        const double sx = static_cast<double>(width) / gray.cols;
+        const double sy = static_cast<double>(height) / gray.rows;
+        camera_matrix = calibration.cameraMatrix().clone();
+        camera_matrix.at<double>(0, 0) *= sx;
+        camera_matrix.at<double>(0, 1) *= sx;
+        camera_matrix.at<double>(0, 2) *= sx;
+        camera_matrix.at<double>(1, 1) *= sy;
+        camera_matrix.at<double>(1, 2) *= sy;
+        for (auto &marker : corners)
+        {
+            for (auto &corner : marker)
+            {
+                corner.x *= sx;
+                corner.y *= sy;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < state.rvecs.size(); ++i)
+    {
+        if (isVec3dZero(state.tvecs[i]))
+        {
+            continue;
+        }
+        // Draw 3D axis on the marker in the image
+        drawAxis(dst, calibration, camera_matrix, state.rvecs[i], state.tvecs[i], marker_size * 0.7f);
+        draw3dAxis(dst, calibration, camera_matrix, marker_size, state.tvecs[i], state.rvecs[i], 1);
+    }
+    if (!state.marker_ids.empty())
+    {
+        cv::aruco::drawDetectedMarkers(dst, corners, state.marker_ids);
+    }
+}
+
+} // namespace aruco_ros2
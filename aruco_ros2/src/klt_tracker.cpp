@@ -0,0 +1,239 @@
+#include "aruco_ros2/klt_tracker.hpp"
+
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+#include <opencv2/video/tracking.hpp>
+
+namespace aruco_ros2
+{
+
+namespace
+{
+// Resolution of the canonical marker image used for verification
+constexpr int kVerifyCellSize = 8;
+constexpr int kVerifyCellMargin = 1;
+} // namespace
+
+KltTracker::KltTracker(const KltTrackerConfig &config) : config_(config)
+{
+}
+
+bool KltTracker::track(uint64_t seq, const cv::Mat &gray, const cv::Ptr<cv::aruco::Dictionary> &dictionary,
+                       int marker_border_bits, std::vector<int> &ids, std::vector<std::vector<cv::Point2f>> &corners)
+{
+    // Take the reference frame under the lock; the tracking itself runs on this copy. The pyramid is
+    // shared, the tracks are small.
+    std::shared_ptr<Pyramid> previous;
+    std::vector<int> previous_ids;
+    std::vector<std::vector<cv::Point2f>> previous_corners;
+    uint64_t keyframe_seq = 0;
+    std::shared_ptr<Pyramid> pyramid;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const bool keyframe_due = !have_keyframe_ ||
+                                  seq >= keyframe_seq_ + static_cast<uint64_t>(std::max(1, config_.keyframe_interval));
+        // A resolution change (camera mode switch) also invalidates the tracks
+        const bool resized = !pyramid_ || pyramid_->empty() || (*pyramid_)[0].size() != gray.size();
+        if (lost_ || ids_.empty() || keyframe_due || resized)
+        {
+            // Claim the keyframe so concurrent workers do not all fall back to detection
+            keyframe_seq_ = seq;
+            have_keyframe_ = true;
+            lost_ = false;
+            return false;
+        }
+        previous = pyramid_;
+        previous_ids = ids_;
+        previous_corners = corners_;
+        keyframe_seq = keyframe_seq_;
+        pyramid = takeSparePyramid();
+    }
+
+    buildPyramid(gray, *pyramid);
+
+    std::vector<cv::Point2f> previous_points;
+    previous_points.reserve(previous_corners.size() * 4);
+    for (const auto &marker : previous_corners)
+    {
+        previous_points.insert(previous_points.end(), marker.begin(), marker.end());
+    }
+
+    // Forward flow, then backward flow as a consistency check
+    const cv::TermCriteria criteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 30, 0.01);
+    std::vector<cv::Point2f> points, back_points;
+    std::vector<uchar> status, back_status;
+    std::vector<float> error;
+    cv::calcOpticalFlowPyrLK(*previous, *pyramid, previous_points, points, status, error,
+                             config_.window_size, config_.max_level, criteria);
+    cv::calcOpticalFlowPyrLK(*pyramid, *previous, points, back_points, back_status, error,
+                             config_.window_size, config_.max_level, criteria);
+    // Drop the reference before committing so the retired pyramid can be recycled
+    previous.reset();
+
+    const bool verify_due = config_.verify_interval > 0 &&
+                            (seq - keyframe_seq) % static_cast<uint64_t>(config_.verify_interval) == 0;
+    const double max_fb_error2 = config_.max_fb_error * config_.max_fb_error;
+
+    ids.clear();
+    corners.clear();
+    for (size_t m = 0; m < previous_ids.size(); ++m)
+    {
+        bool ok = true;
+        std::vector<cv::Point2f> tracked(4);
+        for (size_t c = 0; c < 4 && ok; ++c)
+        {
+            const size_t k = m * 4 + c;
+            const cv::Point2f fb = back_points[k] - previous_points[k];
+            ok = status[k] && back_status[k] && fb.dot(fb) <= max_fb_error2;
+            tracked[c] = points[k];
+        }
+        ok = ok && plausible(previous_corners[m], tracked) &&
+             (!verify_due || verify(gray, tracked, previous_ids[m], *dictionary, marker_border_bits));
+        if (ok)
+        {
+            ids.push_back(previous_ids[m]);
+            corners.push_back(std::move(tracked));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (ids.size() < previous_ids.size())
+    {
+        lost_ = true;
+    }
+    if (seq > seq_)
+    {
+        auto ids_copy = ids;
+        auto corners_copy = corners;
+        commit(seq, std::move(pyramid), std::move(ids_copy), std::move(corners_copy));
+    }
+    else
+    {
+        recycle(std::move(pyramid));
+    }
+    return true;
+}
+
+void KltTracker::keyframe(uint64_t seq, const cv::Mat &gray, const std::vector<int> &ids,
+                          const std::vector<std::vector<cv::Point2f>> &corners)
+{
+    std::shared_ptr<Pyramid> pyramid;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (have_keyframe_ && seq < seq_)
+        {
+            return;
+        }
+        pyramid = takeSparePyramid();
+    }
+
+    buildPyramid(gray, *pyramid);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (seq < seq_)
+    {
+        recycle(std::move(pyramid));
+        return;
+    }
+    commit(seq, std::move(pyramid), std::vector<int>(ids), std::vector<std::vector<cv::Point2f>>(corners));
+}
+
+void KltTracker::buildPyramid(const cv::Mat &gray, Pyramid &pyramid)
+{
+    // The input may be a recycled buffer, so never let level 0 alias it
+    cv::buildOpticalFlowPyramid(gray, pyramid, config_.window_size, config_.max_level, true,
+                                cv::BORDER_REFLECT_101, cv::BORDER_CONSTANT, false);
+}
+
+// Returns a pyramid nobody else references, reusing the spare one's buffers if there is one. Must be
+// called with the mutex held.
+std::shared_ptr<KltTracker::Pyramid> KltTracker::takeSparePyramid()
+{
+    if (spare_pyramid_)
+    {
+        return std::move(spare_pyramid_);
+    }
+    return std::make_shared<Pyramid>();
+}
+
+// Keeps a pyramid for reuse unless a tracking worker still reads from it, in which case its buffers are
+// left to that worker and freed when it is done. Must be called with the mutex held.
+void KltTracker::recycle(std::shared_ptr<Pyramid> &&pyramid)
+{
+    if (pyramid && pyramid.use_count() == 1)
+    {
+        spare_pyramid_ = std::move(pyramid);
+    }
+    pyramid.reset();
+}
+
+// Makes frame `seq` the reference for the next track() call. Must be called with the mutex held.
+void KltTracker::commit(uint64_t seq, std::shared_ptr<Pyramid> &&pyramid, std::vector<int> &&ids,
+                        std::vector<std::vector<cv::Point2f>> &&corners)
+{
+    std::shared_ptr<Pyramid> retired = std::move(pyramid_);
+    pyramid_ = std::move(pyramid);
+    recycle(std::move(retired));
+    ids_ = std::move(ids);
+    corners_ = std::move(corners);
+    seq_ = seq;
+}
+
+// Re-decodes the marker bits at the tracked corners, the same way the detector does, and checks they
+// still identify marker `id` in its original orientation
+bool KltTracker::verify(const cv::Mat &gray, const std::vector<cv::Point2f> &corners, int id,
+                        const cv::aruco::Dictionary &dictionary, int marker_border_bits)
+{
+    const int marker_size = dictionary.markerSize;
+    const int cells = marker_size + 2 * marker_border_bits;
+    const int side = cells * kVerifyCellSize;
+
+    const std::vector<cv::Point2f> canonical = {
+        {0.f, 0.f},
+        {static_cast<float>(side - 1), 0.f},
+        {static_cast<float>(side - 1), static_cast<float>(side - 1)},
+        {0.f, static_cast<float>(side - 1)}};
+    cv::Mat warped;
+    cv::warpPerspective(gray, warped, cv::getPerspectiveTransform(corners, canonical), cv::Size(side, side),
+                        cv::INTER_NEAREST);
+    cv::threshold(warped, warped, 125, 255, cv::THRESH_BINARY | cv::THRESH_OTSU);
+
+    cv::Mat bits(cells, cells, CV_8UC1);
+    const int inner = kVerifyCellSize - 2 * kVerifyCellMargin;
+    for (int y = 0; y < cells; ++y)
+    {
+        for (int x = 0; x < cells; ++x)
+        {
+            const cv::Rect cell(x * kVerifyCellSize + kVerifyCellMargin, y * kVerifyCellSize + kVerifyCellMargin,
+                                inner, inner);
+            bits.at<uchar>(y, x) = cv::countNonZero(warped(cell)) > inner * inner / 2 ? 1 : 0;
+        }
+    }
+
+    // The border must be (mostly) black
+    const cv::Mat only_bits = bits(cv::Rect(marker_border_bits, marker_border_bits, marker_size, marker_size));
+    const int border_errors = cv::countNonZero(bits) - cv::countNonZero(only_bits);
+    if (border_errors > cells)
+    {
+        return false;
+    }
+
+    int idx = -1;
+    int rotation = -1;
+    return dictionary.identify(only_bits.clone(), idx, rotation, 0.6) && idx == id && rotation == 0;
+}
+
+// Rejects quads that stopped being convex or changed area implausibly between two frames
+bool KltTracker::plausible(const std::vector<cv::Point2f> &previous, const std::vector<cv::Point2f> &current)
+{
+    if (!cv::isContourConvex(current))
+    {
+        return false;
+    }
+    const double previous_area = cv::contourArea(previous);
+    const double area = cv::contourArea(current);
+    return previous_area > 0.0 && area > 0.5 * previous_area && area < 2.0 * previous_area;
+}
+
+} // namespace aruco_ros2
@@ -0,0 +1,132 @@
+#include "aruco_ros2/marker_detector.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace aruco_ros2
+{
+
+bool parseTrackingMode(const std::string &name, TrackingMode &mode)
+{
+    if (name == "none")
+    {
+        mode = TrackingMode::None;
+    }
+    else if (name == "roi")
+    {
+        mode = TrackingMode::Roi;
+    }
+    else if (name == "klt")
+    {
+        mode = TrackingMode::Klt;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+MarkerDetector::MarkerDetector(const TrackingConfig &tracking)
+{
+    if (tracking.mode == TrackingMode::Roi)
+    {
+        RoiTrackerConfig tracker_config;
+        tracker_config.full_scan_interval = tracking.full_scan_interval;
+        tracker_config.padding = tracking.roi_padding;
+        roi_tracker_ = std::make_unique<RoiTracker>(tracker_config);
+    }
+    else if (tracking.mode == TrackingMode::Klt)
+    {
+        KltTrackerConfig tracker_config;
+        tracker_config.keyframe_interval = tracking.full_scan_interval;
+        tracker_config.verify_interval = tracking.klt_verify_interval;
+        klt_tracker_ = std::make_unique<KltTracker>(tracker_config);
+    }
+}
+
+bool MarkerDetector::detect(uint64_t seq, const DetectorConfig &config, int effort_level, FrameState &state)
+{
+    resolveDetectorSettings(config, effort_level, state);
+    if (klt_tracker_)
+    {
+        const bool full_scan = !klt_tracker_->track(seq, state.gray, config.dictionary,
+                                                    config.parameters->markerBorderBits, state.marker_ids,
+                                                    state.marker_corners);
+        if (full_scan)
+        {
+            detectFullFrame(config, state);
+            klt_tracker_->keyframe(seq, state.gray, state.marker_ids, state.marker_corners);
+        }
+        else
+        {
+            state.rejected_candidates.clear();
+        }
+        return full_scan;
+    }
+
+    const bool full_scan = !roi_tracker_ || !roi_tracker_->predict(seq, state.gray.size(), state.rois);
+    if (full_scan)
+    {
+        detectFullFrame(config, state);
+    }
+    else
+    {
+        detectInRois(config, state);
+    }
+
+    if (roi_tracker_)
+    {
+        roi_tracker_->update(seq, full_scan, state.marker_ids, state.marker_corners);
+    }
+    return full_scan;
+}
+
+void MarkerDetector::process(uint64_t seq, const cv::Mat &image, const std::string &encoding,
+                             const CameraCalibration &calibration, const DetectorConfig &config, FrameState &state,
+                             std::vector<MarkerDetection> &detections)
+{
+    if (!convertToGray(image, encoding, state))
+    {
+        throw std::invalid_argument("Unsupported image encoding: " + encoding);
+    }
+    detect(seq, config, 0, state);
+    if (state.marker_ids.empty())
+    {
+        state.rvecs.clear();
+        state.tvecs.clear();
+        state.poses.resize(0);
+    }
+    else
+    {
+        solvePoses(calibration, config.marker_size, state);
+    }
+    collectDetections(state, detections);
+}
+
+void collectDetections(const FrameState &state, std::vector<MarkerDetection> &detections)
+{
+    const size_t count = state.marker_ids.size();
+    const bool have_poses = state.poses.size() == count;
+    detections.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        MarkerDetection &detection = detections[i];
+        detection.id = state.marker_ids[i];
+        std::copy_n(state.marker_corners[i].begin(), 4, detection.corners.begin());
+        detection.has_pose = have_poses && state.poses.valid[i];
+        if (detection.has_pose)
+        {
+            const SquarePoseBatch &poses = state.poses;
+            detection.translation = cv::Vec3d(poses.tx[i], poses.ty[i], poses.tz[i]);
+            detection.rotation = cv::Vec4d(poses.qx[i], poses.qy[i], poses.qz[i], poses.qw[i]);
+        }
+        else
+        {
+            detection.translation = cv::Vec3d();
+            detection.rotation = cv::Vec4d(0, 0, 0, 1);
+        }
+    }
+}
+
+} // namespace aruco_ros2
@@ -0,0 +1,52 @@
+#include "aruco_ros2/marker_messages.hpp"
+
+#include <string>
+
+namespace aruco_ros2
+{
+
+size_t appendMarkers(const FrameState &state, const std_msgs::msg::Header &header,
+                     aruco_ros2_msgs::msg::MarkerArray &array)
+{
+    const SquarePoseBatch &poses = state.poses;
+    size_t failed = 0;
+    array.markers.reserve(array.markers.size() + state.marker_ids.size());
+    for (size_t i = 0; i < state.marker_ids.size(); ++i)
+    {
+        if (!poses.valid[i])
+        {
+            ++failed;
+            continue;
+        }
+        aruco_ros2_msgs::msg::Marker &marker = array.markers.emplace_back();
+        marker.header = header;
+        marker.id = state.marker_ids[i];
+        marker.pose.header = header;
+        marker.pose.pose.position.x = poses.tx[i];
+        marker.pose.pose.position.y = poses.ty[i];
+        marker.pose.pose.position.z = poses.tz[i];
+        marker.pose.pose.orientation.x = poses.qx[i];
+        marker.pose.pose.orientation.y = poses.qy[i];
+        marker.pose.pose.orientation.z = poses.qz[i];
+        marker.pose.pose.orientation.w = poses.qw[i];
+        marker.pixel_x = state.marker_corners[i][0].x;
+        marker.pixel_y = state.marker_corners[i][0].y;
+    }
+    return failed;
+}
+
+geometry_msgs::msg::TransformStamped markerTransform(const aruco_ros2_msgs::msg::Marker &marker,
+                                                     const builtin_interfaces::msg::Time &stamp)
+{
+    geometry_msgs::msg::TransformStamped transform;
+    transform.header.stamp = stamp;
+    transform.header.frame_id = marker.header.frame_id;                     // Parent frame
+    transform.child_frame_id = "aruco_marker_" + std::to_string(marker.id); // Marker-specific frame
+    transform.transform.translation.x = marker.pose.pose.position.x;
+    transform.transform.translation.y = marker.pose.pose.position.y;
+    transform.transform.translation.z = marker.pose.pose.position.z;
+    transform.transform.rotation = marker.pose.pose.orientation;
+    return transform;
+}
+
+} // namespace aruco_ros2
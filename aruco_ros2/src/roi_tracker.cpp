@@ -0,0 +1,139 @@
+#include "aruco_ros2/roi_tracker.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace aruco_ros2
+{
+
+RoiTracker::RoiTracker(const RoiTrackerConfig &config)
+    : config_(config)
+{
+}
+
+bool RoiTracker::predict(uint64_t seq, const cv::Size &image_size, std::vector<cv::Rect> &rois)
+{
+    rois.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    const bool interval_elapsed = !have_full_scan_ ||
+                                  seq >= last_full_scan_seq_ + static_cast<uint64_t>(std::max(1, config_.full_scan_interval));
+    if (lost_ || tracks_.empty() || interval_elapsed)
+    {
+        // Claim the full scan so concurrent workers do not all fall back to one
+        last_full_scan_seq_ = seq;
+        have_full_scan_ = true;
+        lost_ = false;
+        return false;
+    }
+
+    const cv::Rect image_rect(0, 0, image_size.width, image_size.height);
+    // With several workers a frame can be predicted from a newer one that finished first; it is then
+    // treated as being at the tracks' position rather than extrapolated backwards
+    const double frames_ahead = seq > last_seq_ ? static_cast<double>(seq - last_seq_) : 0.0;
+    for (const auto &track : tracks_)
+    {
+        const cv::Rect2f box = cv::boundingRect(track.corners);
+        const cv::Point2f shift = track.velocity * static_cast<float>(frames_ahead);
+
+        // Cover both the last position and the constant-velocity prediction
+        cv::Rect2f predicted = box | (box + shift);
+        const float pad = std::max(static_cast<float>(config_.min_padding_px),
+                                   static_cast<float>(config_.padding) * std::max(box.width, box.height));
+        predicted.x -= pad;
+        predicted.y -= pad;
+        predicted.width += 2 * pad;
+        predicted.height += 2 * pad;
+        // Clip in floating point first so a runaway prediction cannot overflow the integer rectangle
+        predicted &= cv::Rect2f(0.f, 0.f, static_cast<float>(image_size.width), static_cast<float>(image_size.height));
+
+        const cv::Rect roi = cv::Rect(cv::Point(static_cast<int>(std::floor(predicted.x)), static_cast<int>(std::floor(predicted.y))),
+                                      cv::Point(static_cast<int>(std::ceil(predicted.br().x)), static_cast<int>(std::ceil(predicted.br().y)))) &
+                             image_rect;
+        if (!roi.empty())
+        {
+            rois.push_back(roi);
+        }
+    }
+    mergeOverlapping(rois);
+    if (rois.empty())
+    {
+        // Every predicted marker left the image: scan the whole frame, and count it as this frame's full scan
+        last_full_scan_seq_ = seq;
+        have_full_scan_ = true;
+        return false;
+    }
+    return true;
+}
+
+void RoiTracker::update(uint64_t seq, bool full_scan, const std::vector<int> &ids,
+                        const std::vector<std::vector<cv::Point2f>> &corners)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (have_update_ && seq <= last_seq_)
+    {
+        return;
+    }
+
+    // A ROI scan cannot find new markers, so any track it misses is lost and the next frame gets a
+    // full scan to re-acquire it
+    size_t found = 0;
+    std::vector<Track> tracks;
+    tracks.reserve(ids.size());
+    const float frames = static_cast<float>(have_update_ ? seq - last_seq_ : 1);
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        Track track{ids[i], corners[i], cv::Point2f(0.f, 0.f)};
+        const auto previous = std::find_if(tracks_.begin(), tracks_.end(), [&](const Track &t)
+                                           { return t.id == ids[i]; });
+        if (previous != tracks_.end())
+        {
+            track.velocity = (centroid(corners[i]) - centroid(previous->corners)) / frames;
+            found++;
+        }
+        tracks.push_back(std::move(track));
+    }
+    if (!full_scan && found < tracks_.size())
+    {
+        lost_ = true;
+    }
+
+    tracks_ = std::move(tracks);
+    last_seq_ = seq;
+    have_update_ = true;
+}
+
+cv::Point2f RoiTracker::centroid(const std::vector<cv::Point2f> &corners)
+{
+    cv::Point2f sum(0.f, 0.f);
+    for (const auto &corner : corners)
+    {
+        sum += corner;
+    }
+    return corners.empty() ? sum : sum / static_cast<float>(corners.size());
+}
+
+// Replaces overlapping rectangles by their union until none overlap, so no marker is searched twice
+void RoiTracker::mergeOverlapping(std::vector<cv::Rect> &rois)
+{
+    bool merged = true;
+    while (merged)
+    {
+        merged = false;
+        for (size_t i = 0; i < rois.size() && !merged; ++i)
+        {
+            for (size_t j = i + 1; j < rois.size(); ++j)
+            {
+                if ((rois[i] & rois[j]).area() > 0)
+                {
+                    rois[i] |= rois[j];
+                    rois.erase(rois.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+} // namespace aruco_ros2
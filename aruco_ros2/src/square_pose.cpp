@@ -0,0 +1,351 @@
+#include "aruco_ros2/square_pose.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace aruco_ros2
+{
+
+void SquarePoseBatch::resize(size_t n)
+{
+    for (auto &c : u)
+    {
+        c.resize(n);
+    }
+    for (auto &c : v)
+    {
+        c.resize(n);
+    }
+    for (auto *c : {&tx, &ty, &tz, &qx, &qy, &qz, &qw, &error, &e1, &e2, &keep})
+    {
+        c->resize(n);
+    }
+    valid.resize(n);
+    for (auto &c : h)
+    {
+        c.resize(n);
+    }
+    for (size_t k = 0; k < 9; ++k)
+    {
+        r1[k].resize(n);
+        r2[k].resize(n);
+    }
+    for (size_t k = 0; k < 3; ++k)
+    {
+        t1[k].resize(n);
+        t2[k].resize(n);
+    }
+}
+
+namespace
+{
+
+struct CornerData
+{
+    double px[4], py[4]; // model corners
+};
+
+// Least-squares translation for a rotation whose first two columns are (r0, r3, r6) and (r1, r4, r7),
+// given the model corners and their normalized image points. Returns the summed squared reprojection
+// error. Takes and returns scalars so that, inlined, it works on the solver's arrays in place and the
+// per-marker loop still vectorizes.
+#if defined(__GNUC__)
+__attribute__((always_inline))
+#endif
+inline double translationAndError(double r0, double r1, double r3, double r4, double r6, double r7,
+                                  const CornerData &model, double u0, double u1, double u2, double u3,
+                                  double v0, double v1, double v2, double v3, double &t0, double &t1, double &t2)
+{
+    const double u[4] = {u0, u1, u2, u3};
+    const double v[4] = {v0, v1, v2, v3};
+
+    // Normal equations of [1 0 -u; 0 1 -v] t = [u*rz - rx; v*rz - ry], accumulated over the corners
+    double ata02 = 0.0, ata12 = 0.0, ata22 = 0.0;
+    double atb0 = 0.0, atb1 = 0.0, atb2 = 0.0;
+#pragma GCC unroll 4
+    for (int k = 0; k < 4; ++k)
+    {
+        const double rx = r0 * model.px[k] + r1 * model.py[k];
+        const double ry = r3 * model.px[k] + r4 * model.py[k];
+        const double rz = r6 * model.px[k] + r7 * model.py[k];
+        const double a = -u[k];
+        const double b = -v[k];
+        const double bx = -a * rz - rx;
+        const double by = -b * rz - ry;
+        ata02 += a;
+        ata12 += b;
+        ata22 += a * a + b * b;
+        atb0 += bx;
+        atb1 += by;
+        atb2 += a * bx + b * by;
+    }
+    const double ata00 = 4.0;
+    const double ata11 = 4.0;
+
+    // Symmetric 3x3 inverse through the adjugate (ata01 is zero)
+    const double c00 = ata11 * ata22 - ata12 * ata12;
+    const double c01 = ata02 * ata12;
+    const double c02 = -ata02 * ata11;
+    const double c11 = ata00 * ata22 - ata02 * ata02;
+    const double c12 = -ata00 * ata12;
+    const double c22 = ata00 * ata11;
+    const double det = ata00 * c00 + ata02 * c02;
+    const double inv = 1.0 / det;
+    t0 = inv * (c00 * atb0 + c01 * atb1 + c02 * atb2);
+    t1 = inv * (c01 * atb0 + c11 * atb1 + c12 * atb2);
+    t2 = inv * (c02 * atb0 + c12 * atb1 + c22 * atb2);
+
+    double error = 0.0;
+#pragma GCC unroll 4
+    for (int k = 0; k < 4; ++k)
+    {
+        const double x = r0 * model.px[k] + r1 * model.py[k] + t0;
+        const double y = r3 * model.px[k] + r4 * model.py[k] + t1;
+        const double z = r6 * model.px[k] + r7 * model.py[k] + t2;
+        const double du = x / z - u[k];
+        const double dv = y / z - v[k];
+        error += du * du + dv * dv;
+    }
+    return error;
+}
+
+inline double select(bool condition, double a, double b)
+{
+    return condition ? a : b;
+}
+
+// std::isfinite as a single comparison, which the vectorizer handles
+inline bool finite(double x)
+{
+    return std::abs(x) <= std::numeric_limits<double>::max();
+}
+
+} // namespace
+
+void solveSquarePoses(SquarePoseBatch &batch, double marker_size)
+{
+    const size_t n = batch.size();
+    const double half = marker_size / 2.0;
+
+    // Model corners, matching cv::aruco::estimatePoseSingleMarkers
+    const CornerData model{{-half, half, half, -half}, {half, half, -half, -half}};
+
+    const double *u0 = batch.u[0].data(), *u1 = batch.u[1].data(), *u2 = batch.u[2].data(), *u3 = batch.u[3].data();
+    const double *v0 = batch.v[0].data(), *v1 = batch.v[1].data(), *v2 = batch.v[2].data(), *v3 = batch.v[3].data();
+    double *h[9];
+    for (int k = 0; k < 9; ++k)
+    {
+        h[k] = batch.h[k].data();
+    }
+
+    // 1. Homography from the model plane to the image. The unit square (s, t) maps onto the corner quad
+    //    in closed form (Heckbert's square-to-quad); the model square maps onto the unit square through
+    //    s = x / size + 1/2, t = -y / size + 1/2.
+    const double inv_size = 1.0 / marker_size;
+#pragma omp simd
+    for (size_t i = 0; i < n; ++i)
+    {
+        const double dx1 = u1[i] - u2[i], dx2 = u3[i] - u2[i], dx3 = u0[i] - u1[i] + u2[i] - u3[i];
+        const double dy1 = v1[i] - v2[i], dy2 = v3[i] - v2[i], dy3 = v0[i] - v1[i] + v2[i] - v3[i];
+        const double den = dx1 * dy2 - dx2 * dy1;
+        const double g = (dx3 * dy2 - dx2 * dy3) / den;
+        const double k = (dx1 * dy3 - dx3 * dy1) / den;
+        const double a = u1[i] - u0[i] + g * u1[i];
+        const double b = u3[i] - u0[i] + k * u3[i];
+        const double c = u0[i];
+        const double d = v1[i] - v0[i] + g * v1[i];
+        const double e = v3[i] - v0[i] + k * v3[i];
+        const double f = v0[i];
+
+        // H = [a b c; d e f; g k 1] * [1/size 0 1/2; 0 -1/size 1/2; 0 0 1]
+        h[0][i] = a * inv_size;
+        h[1][i] = -b * inv_size;
+        h[2][i] = 0.5 * (a + b) + c;
+        h[3][i] = d * inv_size;
+        h[4][i] = -e * inv_size;
+        h[5][i] = 0.5 * (d + e) + f;
+        h[6][i] = g * inv_size;
+        h[7][i] = -k * inv_size;
+        h[8][i] = 0.5 * (g + k) + 1.0;
+    }
+
+    // 2. IPPE: the two rotations consistent with the homography's Jacobian at the model origin
+    double *r1[9], *r2[9];
+    for (int k = 0; k < 9; ++k)
+    {
+        r1[k] = batch.r1[k].data();
+        r2[k] = batch.r2[k].data();
+    }
+#pragma omp simd
+    for (size_t i = 0; i < n; ++i)
+    {
+        // Image of the model origin, and the Jacobian of the homography there
+        const double inv_h22 = 1.0 / h[8][i];
+        const double p = h[2][i] * inv_h22;
+        const double q = h[5][i] * inv_h22;
+        const double j00 = (h[0][i] - h[6][i] * p) * inv_h22;
+        const double j01 = (h[1][i] - h[7][i] * p) * inv_h22;
+        const double j10 = (h[3][i] - h[6][i] * q) * inv_h22;
+        const double j11 = (h[4][i] - h[7][i] * q) * inv_h22;
+
+        // Rotation taking (p, q, 1) onto the z axis (transposed)
+        const double nrm = std::sqrt(p * p + q * q + 1.0);
+        const double ax = p / nrm, ay = q / nrm, az = 1.0 / nrm;
+        const double dd = 1.0 / (1.0 + az);
+        const double rv00 = 1.0 - ax * ax * dd, rv01 = -ax * ay * dd, rv02 = ax;
+        const double rv10 = -ax * ay * dd, rv11 = 1.0 - ay * ay * dd, rv12 = ay;
+        const double rv20 = -ax, rv21 = -ay, rv22 = 1.0 - (ax * ax + ay * ay) * dd;
+
+        // A = inv(B) * J, with B the 2x2 block of the perspective projection at (p, q)
+        const double b00 = rv00 - p * rv20, b01 = rv01 - p * rv21;
+        const double b10 = rv10 - q * rv20, b11 = rv11 - q * rv21;
+        const double dtinv = 1.0 / (b00 * b11 - b01 * b10);
+        const double bi00 = dtinv * b11, bi01 = -dtinv * b01;
+        const double bi10 = -dtinv * b10, bi11 = dtinv * b00;
+        const double a00 = bi00 * j00 + bi01 * j10, a01 = bi00 * j01 + bi01 * j11;
+        const double a10 = bi10 * j00 + bi11 * j10, a11 = bi10 * j01 + bi11 * j11;
+
+        // Largest singular value of A
+        const double ata00 = a00 * a00 + a01 * a01;
+        const double ata01 = a00 * a10 + a01 * a11;
+        const double ata11 = a10 * a10 + a11 * a11;
+        const double gamma2 = 0.5 * (ata00 + ata11 + std::sqrt((ata00 - ata11) * (ata00 - ata11) + 4.0 * ata01 * ata01));
+        const double gamma = std::sqrt(gamma2);
+
+        const double rt00 = a00 / gamma, rt01 = a01 / gamma, rt10 = a10 / gamma, rt11 = a11 / gamma;
+        const double b0 = std::sqrt(std::max(0.0, 1.0 - rt00 * rt00 - rt10 * rt10));
+        const double b1_abs = std::sqrt(std::max(0.0, 1.0 - rt01 * rt01 - rt11 * rt11));
+        const double b1 = (-rt00 * rt01 - rt10 * rt11) < 0.0 ? -b1_abs : b1_abs;
+
+        const double c0 = b1 * rt10 - b0 * rt11;
+        const double c1 = b0 * rt01 - b1 * rt00;
+        const double c2 = rt00 * rt11 - rt01 * rt10;
+
+        r1[0][i] = rt00 * rv00 + rt10 * rv01 + b0 * rv02;
+        r1[1][i] = rt01 * rv00 + rt11 * rv01 + b1 * rv02;
+        r1[2][i] = c0 * rv00 + c1 * rv01 + c2 * rv02;
+        r1[3][i] = rt00 * rv10 + rt10 * rv11 + b0 * rv12;
+        r1[4][i] = rt01 * rv10 + rt11 * rv11 + b1 * rv12;
+        r1[5][i] = c0 * rv10 + c1 * rv11 + c2 * rv12;
+        r1[6][i] = rt00 * rv20 + rt10 * rv21 + b0 * rv22;
+        r1[7][i] = rt01 * rv20 + rt11 * rv21 + b1 * rv22;
+        r1[8][i] = c0 * rv20 + c1 * rv21 + c2 * rv22;
+
+        r2[0][i] = rt00 * rv00 + rt10 * rv01 - b0 * rv02;
+        r2[1][i] = rt01 * rv00 + rt11 * rv01 - b1 * rv02;
+        r2[2][i] = -c0 * rv00 - c1 * rv01 + c2 * rv02;
+        r2[3][i] = rt00 * rv10 + rt10 * rv11 - b0 * rv12;
+        r2[4][i] = rt01 * rv10 + rt11 * rv11 - b1 * rv12;
+        r2[5][i] = -c0 * rv10 - c1 * rv11 + c2 * rv12;
+        r2[6][i] = rt00 * rv20 + rt10 * rv21 - b0 * rv22;
+        r2[7][i] = rt01 * rv20 + rt11 * rv21 - b1 * rv22;
+        r2[8][i] = -c0 * rv20 - c1 * rv21 + c2 * rv22;
+    }
+
+    // 3. Translation of each rotation by linear least squares over the corners, and its reprojection error
+    double *t1[3], *t2[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        t1[k] = batch.t1[k].data();
+        t2[k] = batch.t2[k].data();
+    }
+    double *e1 = batch.e1.data(), *e2 = batch.e2.data();
+#pragma omp simd
+    for (size_t i = 0; i < n; ++i)
+    {
+        e1[i] = translationAndError(r1[0][i], r1[1][i], r1[3][i], r1[4][i], r1[6][i], r1[7][i], model,
+                                    u0[i], u1[i], u2[i], u3[i], v0[i], v1[i], v2[i], v3[i],
+                                    t1[0][i], t1[1][i], t1[2][i]);
+        e2[i] = translationAndError(r2[0][i], r2[1][i], r2[3][i], r2[4][i], r2[6][i], r2[7][i], model,
+                                    u0[i], u1[i], u2[i], u3[i], v0[i], v1[i], v2[i], v3[i],
+                                    t2[0][i], t2[1][i], t2[2][i]);
+    }
+
+    // 4. Keep the better solution in front of the camera and convert its rotation straight to a quaternion (branch-free
+    //    magnitudes from the diagonal, signs from the skew part)
+    double *tx = batch.tx.data(), *ty = batch.ty.data(), *tz = batch.tz.data();
+    double *qx = batch.qx.data(), *qy = batch.qy.data(), *qz = batch.qz.data(), *qw = batch.qw.data();
+    double *error = batch.error.data();
+    double *keep = batch.keep.data();
+    unsigned char *valid = batch.valid.data();
+#pragma omp simd
+    for (size_t i = 0; i < n; ++i)
+    {
+        // The rotation and the lateral translation are blended with 0/1 weights rather than selected: GCC
+        // merges a run of selects on one condition into a branch and the loop no longer vectorizes. The
+        // blend is exact for finite values; a non-finite loser makes the result non-finite, which only
+        // happens for quads that are degenerate anyway and are dropped below.
+        const double s1 = select(t1[2][i] > 0.0, e1[i], HUGE_VAL);
+        const double s2 = select(t2[2][i] > 0.0, e2[i], HUGE_VAL);
+        const bool first = !(s2 < s1);
+        const double w1 = select(first, 1.0, 0.0), w2 = 1.0 - w1;
+        const double m00 = w1 * r1[0][i] + w2 * r2[0][i];
+        const double m01 = w1 * r1[1][i] + w2 * r2[1][i];
+        const double m02 = w1 * r1[2][i] + w2 * r2[2][i];
+        const double m10 = w1 * r1[3][i] + w2 * r2[3][i];
+        const double m11 = w1 * r1[4][i] + w2 * r2[4][i];
+        const double m12 = w1 * r1[5][i] + w2 * r2[5][i];
+        const double m20 = w1 * r1[6][i] + w2 * r2[6][i];
+        const double m21 = w1 * r1[7][i] + w2 * r2[7][i];
+        const double m22 = w1 * r1[8][i] + w2 * r2[8][i];
+        const double px = w1 * t1[0][i] + w2 * t2[0][i];
+        const double py = w1 * t1[1][i] + w2 * t2[1][i];
+        const double pz = select(first, t1[2][i], t2[2][i]);
+        tx[i] = px;
+        ty[i] = py;
+        tz[i] = pz;
+        const double e = select(first, e1[i], e2[i]);
+        error[i] = std::sqrt(e / 4.0);
+
+        const double w = 0.5 * std::sqrt(std::max(0.0, 1.0 + m00 + m11 + m22));
+        const double x = 0.5 * std::sqrt(std::max(0.0, 1.0 + m00 - m11 - m22));
+        const double y = 0.5 * std::sqrt(std::max(0.0, 1.0 - m00 + m11 - m22));
+        const double z = 0.5 * std::sqrt(std::max(0.0, 1.0 - m00 - m11 + m22));
+        const double sx = std::copysign(x, m21 - m12);
+        const double sy = std::copysign(y, m02 - m20);
+        const double sz = std::copysign(z, m10 - m01);
+        const double inv = 1.0 / std::sqrt(w * w + sx * sx + sy * sy + sz * sz);
+        qx[i] = sx * inv;
+        qy[i] = sy * inv;
+        qz[i] = sz * inv;
+        qw[i] = w * inv;
+
+        // Degenerate quads (collinear corners, marker edge-on) show up as non-finite values
+        keep[i] = select(finite(e) && finite(px) && finite(py) && finite(pz) && finite(inv) && pz > 0.0, 1.0, 0.0);
+    }
+
+    // 5. Narrow the flags to bytes in a loop of their own; SSE2 has no instruction to narrow a double comparison
+    //    mask, so doing it in stage 4 would keep that loop scalar
+#pragma omp simd
+    for (size_t i = 0; i < n; ++i)
+    {
+        valid[i] = static_cast<unsigned char>(keep[i]);
+    }
+}
+
+void quaternionToRotationVector(double qx, double qy, double qz, double qw, double rvec[3])
+{
+    // Keep the angle in [0, pi]
+    if (qw < 0.0)
+    {
+        qx = -qx;
+        qy = -qy;
+        qz = -qz;
+        qw = -qw;
+    }
+    const double s = std::sqrt(qx * qx + qy * qy + qz * qz);
+    if (s < 1e-12)
+    {
+        rvec[0] = 2.0 * qx;
+        rvec[1] = 2.0 * qy;
+        rvec[2] = 2.0 * qz;
+        return;
+    }
+    const double scale = 2.0 * std::atan2(s, qw) / s;
+    rvec[0] = qx * scale;
+    rvec[1] = qy * scale;
+    rvec[2] = qz * scale;
+}
+
+} // namespace aruco_ros2
@@ -0,0 +1,408 @@
+#include "aruco_ros2/synthetic_scene.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <stdexcept>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "aruco_ros2/frame_processing.hpp"
+
+namespace aruco_ros2
+{
+
+namespace
+{
+
+cv::Vec4d rotationToQuaternion(const cv::Matx33d &r)
+{
+    double x, y, z, w;
+    const double trace = r(0, 0) + r(1, 1) + r(2, 2);
+    if (trace > 0.0)
+    {
+        const double s = std::sqrt(trace + 1.0) * 2.0;
+        w = 0.25 * s;
+        x = (r(2, 1) - r(1, 2)) / s;
+        y = (r(0, 2) - r(2, 0)) / s;
+        z = (r(1, 0) - r(0, 1)) / s;
+    }
+    else if (r(0, 0) > r(1, 1) && r(0, 0) > r(2, 2))
+    {
+        const double s = std::sqrt(1.0 + r(0, 0) - r(1, 1) - r(2, 2)) * 2.0;
+        w = (r(2, 1) - r(1, 2)) / s;
+        x = 0.25 * s;
+        y = (r(0, 1) + r(1, 0)) / s;
+        z = (r(0, 2) + r(2, 0)) / s;
+    }
+    else if (r(1, 1) > r(2, 2))
+    {
+        const double s = std::sqrt(1.0 + r(1, 1) - r(0, 0) - r(2, 2)) * 2.0;
+        w = (r(0, 2) - r(2, 0)) / s;
+        x = (r(0, 1) + r(1, 0)) / s;
+        y = 0.25 * s;
+        z = (r(1, 2) + r(2, 1)) / s;
+    }
+    else
+    {
+        const double s = std::sqrt(1.0 + r(2, 2) - r(0, 0) - r(1, 1)) * 2.0;
+        w = (r(1, 0) - r(0, 1)) / s;
+        x = (r(0, 2) + r(2, 0)) / s;
+        y = (r(1, 2) + r(2, 1)) / s;
+        z = 0.25 * s;
+    }
+    const double sign = w < 0.0 ? -1.0 : 1.0;
+    return cv::Vec4d(sign * x, sign * y, sign * z, sign * w);
+}
+
+cv::Matx33d rotation(const cv::Vec3d &rvec)
+{
+    cv::Matx33d r;
+    cv::Rodrigues(rvec, r);
+    return r;
+}
+
+bool inside(const std::vector<cv::Point2f> &points, const cv::Rect &rect)
+{
+    for (const auto &point : points)
+    {
+        if (point.x < rect.x || point.y < rect.y || point.x > rect.x + rect.width - 1 ||
+            point.y > rect.y + rect.height - 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+SceneGenerator::SceneGenerator(const SceneConfig &config, std::shared_ptr<const CameraCalibration> calibration)
+    : config_(config), calibration_(std::move(calibration)), rng_(config.seed)
+{
+    dictionary_ = cv::aruco::getPredefinedDictionary(dictNameToEnum(config_.dictionary_name));
+    const int available = dictionary_->bytesList.rows;
+    if (config_.marker_count < 0 || config_.marker_count > available)
+    {
+        throw std::invalid_argument(config_.dictionary_name + " has " + std::to_string(available) + " ids, " +
+                                    std::to_string(config_.marker_count) + " markers requested");
+    }
+    ids_.resize(available);
+    for (int i = 0; i < available; ++i)
+    {
+        ids_[i] = i;
+    }
+}
+
+void SceneGenerator::render(cv::Mat &image, std::vector<SceneMarker> &markers)
+{
+    const cv::Size size = config_.image_size;
+    gray_.create(size, CV_8UC1);
+    gray_.setTo(cv::Scalar(rng_.uniform(150, 230)));
+    drawClutter(gray_);
+
+    // One marker per grid cell, in random cells with random distinct ids
+    markers.clear();
+    const int count = config_.marker_count;
+    if (count > 0)
+    {
+        const double aspect = static_cast<double>(size.width) / size.height;
+        const int cols = std::max(1, static_cast<int>(std::ceil(std::sqrt(count * aspect))));
+        const int rows = (count + cols - 1) / cols;
+        cells_.resize(cols * rows);
+        for (int i = 0; i < cols * rows; ++i)
+        {
+            cells_[i] = i;
+        }
+        const auto shuffle = [this](std::vector<int> &values, int n)
+        {
+            for (int i = 0; i < n; ++i)
+            {
+                std::swap(values[i], values[rng_.uniform(i, static_cast<int>(values.size()))]);
+            }
+        };
+        shuffle(cells_, count);
+        shuffle(ids_, count);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const int col = cells_[i] % cols;
+            const int row = cells_[i] / cols;
+            const cv::Rect cell(col * size.width / cols, row * size.height / rows,
+                                (col + 1) * size.width / cols - col * size.width / cols,
+                                (row + 1) * size.height / rows - row * size.height / rows);
+            SceneMarker marker;
+            if (placeMarker(ids_[i], cell, gray_, marker))
+            {
+                markers.push_back(marker);
+            }
+        }
+    }
+
+    if (config_.lighting > 0.0)
+    {
+        applyLighting(gray_);
+    }
+    if (config_.blur_sigma > 0.0)
+    {
+        cv::GaussianBlur(gray_, gray_, cv::Size(0, 0), config_.blur_sigma);
+    }
+    if (config_.noise_sigma > 0.0)
+    {
+        noise_.create(size, CV_16SC1);
+        rng_.fill(noise_, cv::RNG::NORMAL, 0.0, config_.noise_sigma);
+        cv::add(gray_, noise_, noise_, cv::noArray(), CV_16S);
+        noise_.convertTo(gray_, CV_8U);
+    }
+
+    if (config_.color)
+    {
+        cv::cvtColor(gray_, image, cv::COLOR_GRAY2BGR);
+    }
+    else
+    {
+        gray_.copyTo(image);
+    }
+}
+
+// Random rectangles, discs and lines, and dark squares with a light inside that look like marker
+// candidates to the contour stage but fail to decode
+void SceneGenerator::drawClutter(cv::Mat &gray)
+{
+    const double scale = std::min(gray.cols, gray.rows);
+    for (int i = 0; i < config_.clutter; ++i)
+    {
+        const cv::Point2f center(rng_.uniform(0.f, static_cast<float>(gray.cols)),
+                                 rng_.uniform(0.f, static_cast<float>(gray.rows)));
+        const double extent = rng_.uniform(0.01, 0.08) * scale;
+        const cv::Scalar shade(rng_.uniform(0, 256));
+        const cv::Size2f box(static_cast<float>(extent), static_cast<float>(extent * rng_.uniform(0.3, 1.0)));
+        switch (rng_.uniform(0, 4))
+        {
+        case 0:
+        {
+            cv::Point2f corners[4];
+            cv::RotatedRect(center, box, rng_.uniform(0.f, 180.f)).points(corners);
+            std::vector<cv::Point> polygon(corners, corners + 4);
+            cv::fillConvexPoly(gray, polygon, shade, cv::LINE_AA);
+            break;
+        }
+        case 1:
+            cv::circle(gray, center, static_cast<int>(extent / 2), shade, cv::FILLED, cv::LINE_AA);
+            break;
+        case 2:
+        {
+            const double angle = rng_.uniform(0.0, CV_PI);
+            const cv::Point2f half(static_cast<float>(std::cos(angle) * extent), static_cast<float>(std::sin(angle) * extent));
+            cv::line(gray, center - half, center + half, shade, std::max(1, static_cast<int>(extent / 20)), cv::LINE_AA);
+            break;
+        }
+        default:
+        {
+            const float angle = rng_.uniform(0.f, 90.f);
+            cv::Point2f outer[4], inner[4];
+            cv::RotatedRect(center, cv::Size2f(box.width, box.width), angle).points(outer);
+            cv::RotatedRect(center, cv::Size2f(box.width * 0.6f, box.width * 0.6f), angle).points(inner);
+            cv::fillConvexPoly(gray, std::vector<cv::Point>(outer, outer + 4), cv::Scalar(rng_.uniform(0, 60)), cv::LINE_AA);
+            cv::fillConvexPoly(gray, std::vector<cv::Point>(inner, inner + 4), cv::Scalar(rng_.uniform(120, 256)), cv::LINE_AA);
+            break;
+        }
+        }
+    }
+}
+
+// Puts a marker with a random pose in `cell`: centred near a random point of the cell, at the distance
+// where it covers about `fill` of it, tilted by up to max_tilt_deg and spun freely. The marker and its
+// one-cell white quiet zone have to fit the cell, otherwise it is retried smaller.
+bool SceneGenerator::placeMarker(int id, const cv::Rect &cell, cv::Mat &gray, SceneMarker &marker)
+{
+    const double focal = calibration_->cameraMatrix().at<double>(0, 0);
+    const int cells = dictionary_->markerSize + 2 * config_.marker_border_bits;
+    const double quiet_ratio = (cells + 2.0) / cells;
+    const double half = config_.marker_size / 2.0;
+    const double quiet_half = half * quiet_ratio;
+    const std::vector<cv::Point3f> object{
+        {static_cast<float>(-half), static_cast<float>(half), 0.f},
+        {static_cast<float>(half), static_cast<float>(half), 0.f},
+        {static_cast<float>(half), static_cast<float>(-half), 0.f},
+        {static_cast<float>(-half), static_cast<float>(-half), 0.f},
+        {static_cast<float>(-quiet_half), static_cast<float>(quiet_half), 0.f},
+        {static_cast<float>(quiet_half), static_cast<float>(quiet_half), 0.f},
+        {static_cast<float>(quiet_half), static_cast<float>(-quiet_half), 0.f},
+        {static_cast<float>(-quiet_half), static_cast<float>(-quiet_half), 0.f},
+    };
+
+    double side_px = config_.fill * std::min(cell.width, cell.height) / quiet_ratio * rng_.uniform(0.8, 1.0);
+    std::vector<cv::Point2f> projected, centre(1), normalized;
+    for (int attempt = 0; attempt < 8; ++attempt, side_px *= 0.85)
+    {
+        if (side_px < cells)
+        {
+            return false;
+        }
+        const double slack_x = std::max(0.0, cell.width - side_px * quiet_ratio) / 2.0;
+        const double slack_y = std::max(0.0, cell.height - side_px * quiet_ratio) / 2.0;
+        centre[0] = cv::Point2f(static_cast<float>(cell.x + cell.width / 2.0 + rng_.uniform(-slack_x, slack_x + 1e-9)),
+                                static_cast<float>(cell.y + cell.height / 2.0 + rng_.uniform(-slack_y, slack_y + 1e-9)));
+        calibration_->undistort(centre, normalized);
+        const double z = focal * config_.marker_size / side_px;
+        const cv::Vec3d tvec(normalized[0].x * z, normalized[0].y * z, z);
+
+        // Facing the camera (rotated half a turn about x), spun about its normal, then tilted about an
+        // axis in the image plane
+        const double tilt = rng_.uniform(0.0, config_.max_tilt_deg * CV_PI / 180.0);
+        const double axis = rng_.uniform(0.0, 2.0 * CV_PI);
+        const double spin = rng_.uniform(0.0, 2.0 * CV_PI);
+        const cv::Matx33d r = rotation(cv::Vec3d(std::cos(axis), std::sin(axis), 0.0) * tilt) *
+                              rotation(cv::Vec3d(CV_PI, 0.0, 0.0)) * rotation(cv::Vec3d(0.0, 0.0, spin));
+        cv::Vec3d rvec;
+        cv::Rodrigues(r, rvec);
+
+        calibration_->project(object, rvec, tvec, cv::Mat(), projected);
+        const std::vector<cv::Point2f> quiet(projected.begin() + 4, projected.end());
+        if (!inside(quiet, cell))
+        {
+            continue;
+        }
+
+        // Marker bitmap with a white quiet zone, at about the projected resolution
+        const int pixels_per_cell = std::max(1, static_cast<int>(std::ceil(side_px / cells)));
+        const int bits_px = cells * pixels_per_cell;
+        cv::aruco::drawMarker(dictionary_, id, bits_px, bitmap_, config_.marker_border_bits);
+        cv::copyMakeBorder(bitmap_, bitmap_, pixels_per_cell, pixels_per_cell, pixels_per_cell, pixels_per_cell,
+                           cv::BORDER_CONSTANT, cv::Scalar(255));
+
+        // Pixel centres are at integer coordinates, so the marker's outer edge lies half a pixel before
+        // its first black pixel
+        const float q = pixels_per_cell - 0.5f;
+        const float e = q + bits_px;
+        const std::vector<cv::Point2f> source{{q, q}, {e, q}, {e, e}, {q, e}};
+        const std::vector<cv::Point2f> target(projected.begin(), projected.begin() + 4);
+        const cv::Matx33d homography = cv::getPerspectiveTransform(source, target);
+
+        const cv::Rect box = (cv::boundingRect(quiet) + cv::Size(2, 2) - cv::Point(1, 1)) & cv::Rect(cv::Point(), gray.size());
+        const cv::Matx33d shift(1, 0, -box.x, 0, 1, -box.y, 0, 0, 1);
+        cv::warpPerspective(bitmap_, patch_, shift * homography, box.size(), cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0));
+        cv::warpPerspective(cv::Mat(bitmap_.size(), CV_8UC1, cv::Scalar(255)), mask_, shift * homography, box.size(),
+                            cv::INTER_LINEAR, cv::BORDER_CONSTANT, cv::Scalar(0));
+
+        // Blend by coverage so the marker's outline is antialiased like a real edge
+        for (int y = 0; y < box.height; ++y)
+        {
+            uchar *dst = gray.ptr<uchar>(box.y + y) + box.x;
+            const uchar *src = patch_.ptr<uchar>(y);
+            const uchar *alpha = mask_.ptr<uchar>(y);
+            for (int x = 0; x < box.width; ++x)
+            {
+                dst[x] = static_cast<uchar>((src[x] * alpha[x] + dst[x] * (255 - alpha[x]) + 127) / 255);
+            }
+        }
+
+        marker.id = id;
+        marker.translation = tvec;
+        marker.rotation = rotationToQuaternion(r);
+        std::copy(target.begin(), target.end(), marker.corners.begin());
+        return true;
+    }
+    return false;
+}
+
+// Brightness falls off linearly along a random direction, by up to `lighting` at the far side
+void SceneGenerator::applyLighting(cv::Mat &gray)
+{
+    const double angle = rng_.uniform(0.0, 2.0 * CV_PI);
+    const double c = std::cos(angle);
+    const double s = std::sin(angle);
+    const double radius = 0.5 * std::hypot(gray.cols, gray.rows);
+    const double step = -config_.lighting * c / (2.0 * radius);
+    for (int y = 0; y < gray.rows; ++y)
+    {
+        uchar *row = gray.ptr<uchar>(y);
+        double gain = 1.0 - config_.lighting * ((-0.5 * gray.cols * c + (y - 0.5 * gray.rows) * s) / radius + 1.0) / 2.0;
+        for (int x = 0; x < gray.cols; ++x, gain += step)
+        {
+            row[x] = cv::saturate_cast<uchar>(row[x] * gain);
+        }
+    }
+}
+
+std::shared_ptr<const CameraCalibration> makePinholeCalibration(const cv::Size &image_size, const cv::Mat &distortion,
+                                                                DistortionModel model)
+{
+    const cv::Mat camera_matrix = (cv::Mat_<double>(3, 3) << image_size.width, 0, image_size.width / 2.0,
+                                   0, image_size.width, image_size.height / 2.0,
+                                   0, 0, 1);
+    return std::make_shared<const CameraCalibration>(image_size, camera_matrix, distortion, model);
+}
+
+bool parseResolution(const std::string &text, cv::Size &size)
+{
+    if (text == "vga")
+    {
+        size = cv::Size(640, 480);
+    }
+    else if (text == "hd")
+    {
+        size = cv::Size(1280, 720);
+    }
+    else if (text == "fhd")
+    {
+        size = cv::Size(1920, 1080);
+    }
+    else if (text == "4k")
+    {
+        size = cv::Size(3840, 2160);
+    }
+    else if (text == "8k")
+    {
+        size = cv::Size(7680, 4320);
+    }
+    else
+    {
+        int width = 0, height = 0;
+        char separator = 0;
+        if (std::sscanf(text.c_str(), "%d%c%d", &width, &separator, &height) != 3 || separator != 'x' ||
+            width <= 0 || height <= 0)
+        {
+            return false;
+        }
+        size = cv::Size(width, height);
+    }
+    return true;
+}
+
+void writeGroundTruthHeader(std::ostream &out)
+{
+    out << "image,id,tx,ty,tz,qx,qy,qz,qw,x0,y0,x1,y1,x2,y2,x3,y3\n";
+}
+
+void writeGroundTruth(std::ostream &out, const std::string &image_name, const std::vector<SceneMarker> &markers)
+{
+    const std::ios::fmtflags flags = out.flags();
+    const std::streamsize precision = out.precision();
+    out << std::fixed;
+    for (const SceneMarker &marker : markers)
+    {
+        out << image_name << ',' << marker.id << std::setprecision(6);
+        for (int k = 0; k < 3; ++k)
+        {
+            out << ',' << marker.translation[k];
+        }
+        for (int k = 0; k < 4; ++k)
+        {
+            out << ',' << marker.rotation[k];
+        }
+        out << std::setprecision(3);
+        for (const cv::Point2f &corner : marker.corners)
+        {
+            out << ',' << corner.x << ',' << corner.y;
+        }
+        out << '\n';
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+} // namespace aruco_ros2
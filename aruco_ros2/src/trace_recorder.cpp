@@ -0,0 +1,181 @@
+#include "aruco_ros2/trace_recorder.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace aruco_ros2
+{
+
+namespace
+{
+
+size_t roundUpPow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n)
+    {
+        p <<= 1;
+    }
+    return p;
+}
+
+void writeJsonString(std::ostream &out, const std::string &value)
+{
+    out << '"';
+    for (char c : value)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out << '\\' << c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20)
+        {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            out << escaped;
+        }
+        else
+        {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+TraceRecorder::TraceRecorder(size_t capacity)
+    : capacity_(roundUpPow2(std::max<size_t>(capacity, 1))), mask_(capacity_ - 1), epoch_(Clock::now()),
+      slots_(capacity_)
+{
+}
+
+uint32_t TraceRecorder::threadId()
+{
+    static std::atomic<uint32_t> next_id{1};
+    thread_local const uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
+
+void TraceRecorder::record(const char *name, size_t camera, Clock::time_point start, Clock::time_point end,
+                           int64_t stamp_ns, uint64_t frame, size_t markers)
+{
+    const uint64_t index = next_.fetch_add(1, std::memory_order_relaxed);
+    Slot &slot = slots_[index & mask_];
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    TraceSpan &span = slot.span;
+    span.name = name;
+    span.camera = static_cast<uint32_t>(camera);
+    span.thread = threadId();
+    span.start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch_).count();
+    span.duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    span.stamp_ns = stamp_ns;
+    span.frame = frame;
+    span.markers = static_cast<uint32_t>(markers);
+
+    slot.sequence.store(2 * (index + 1), std::memory_order_release);
+}
+
+void TraceRecorder::nameThread(const std::string &name)
+{
+    const uint32_t id = threadId();
+    std::lock_guard<std::mutex> lock(names_mutex_);
+    thread_names_[id] = name;
+}
+
+std::vector<TraceSpan> TraceRecorder::spans() const
+{
+    const uint64_t end = next_.load(std::memory_order_acquire);
+    const uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+
+    std::vector<TraceSpan> result;
+    result.reserve(static_cast<size_t>(end - begin));
+    for (uint64_t index = begin; index < end; ++index)
+    {
+        const Slot &slot = slots_[index & mask_];
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before != 2 * (index + 1))
+        {
+            // Still being written, or already overwritten by a newer span
+            continue;
+        }
+        TraceSpan span = slot.span;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before)
+        {
+            result.push_back(span);
+        }
+    }
+    return result;
+}
+
+long TraceRecorder::writeChromeTrace(const std::string &path, const std::vector<std::string> &camera_names) const
+{
+    const std::vector<TraceSpan> all = spans();
+    std::map<uint32_t, std::string> thread_names;
+    {
+        std::lock_guard<std::mutex> lock(names_mutex_);
+        thread_names = thread_names_;
+    }
+
+    std::ofstream out(path);
+    if (!out)
+    {
+        return -1;
+    }
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    const auto separator = [&out, &first]()
+    {
+        out << (first ? "" : ",\n");
+        first = false;
+    };
+
+    // Metadata: one process per camera, and the names of the threads seen in each of them
+    std::map<uint32_t, std::vector<uint32_t>> camera_threads;
+    for (const TraceSpan &span : all)
+    {
+        auto &threads = camera_threads[span.camera];
+        if (std::find(threads.begin(), threads.end(), span.thread) == threads.end())
+        {
+            threads.push_back(span.thread);
+        }
+    }
+    for (const auto &entry : camera_threads)
+    {
+        const uint32_t camera = entry.first;
+        separator();
+        out << "{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":" << camera << ",\"tid\":0,\"args\":{\"name\":";
+        writeJsonString(out, camera < camera_names.size() ? camera_names[camera] : "camera " + std::to_string(camera));
+        out << "}}";
+        for (uint32_t thread : entry.second)
+        {
+            const auto name = thread_names.find(thread);
+            separator();
+            out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":" << camera << ",\"tid\":" << thread
+                << ",\"args\":{\"name\":";
+            writeJsonString(out, name != thread_names.end() ? name->second : "thread " + std::to_string(thread));
+            out << "}}";
+        }
+    }
+
+    // Complete events, timestamps in microseconds
+    char times[64];
+    for (const TraceSpan &span : all)
+    {
+        separator();
+        std::snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f", span.start_ns / 1000.0,
+                      span.duration_ns / 1000.0);
+        out << "{\"ph\":\"X\",\"name\":\"" << span.name << "\",\"cat\":\"aruco_ros2\",\"pid\":" << span.camera
+            << ",\"tid\":" << span.thread << ',' << times << ",\"args\":{\"frame\":" << span.frame
+            << ",\"stamp_ns\":" << span.stamp_ns << ",\"markers\":" << span.markers << "}}";
+    }
+    out << "\n]}\n";
+    out.close();
+    return out ? static_cast<long>(all.size()) : -1;
+}
+
+} // namespace aruco_ros2
@@ -0,0 +1,439 @@
+// Performance regression tests. MarkerDetector runs on deterministic synthetic corpora. The steady-state
+// time and number of allocations per frame, and the recall, are checked against
+// test/performance_baseline.yaml in two ways: against the fixed limits in its `limits` section, which
+// scale with the frame size and apply on any machine, and, for cases recorded there, against the
+// recorded values within the tolerances.
+//
+// Machines differ in speed. So the frame time is divided by the time of a fixed OpenCV reference
+// workload measured just before the case, and the tests compare these ratios rather than milliseconds.
+// Record the cases on the machine that runs the tests, in the build type it uses (Release):
+//
+//   colcon build --packages-select aruco_ros2 --cmake-args -DCMAKE_BUILD_TYPE=Release
+//   ARUCO_PERF_UPDATE_BASELINE=1 colcon test --packages-select aruco_ros2 --ctest-args -R test_performance
+//
+// or run the test binary with --update-baseline.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "aruco_ros2/frame_processing.hpp"
+#include "aruco_ros2/marker_detector.hpp"
+#include "aruco_ros2/synthetic_scene.hpp"
+
+using namespace aruco_ros2;
+
+namespace
+{
+
+std::atomic<bool> g_counting{false};
+std::atomic<size_t> g_allocations{0};
+
+void countAllocation()
+{
+    if (g_counting.load(std::memory_order_relaxed))
+    {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// cv::Mat buffers don't go through operator new, so they are counted by the default Mat allocator
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usage) const override
+    {
+        if (!data)
+        {
+            countAllocation();
+        }
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage);
+    }
+
+    bool allocate(cv::UMatData *data, cv::AccessFlag flags, cv::UMatUsageFlags usage) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(data, flags, usage);
+    }
+
+    void deallocate(cv::UMatData *data) const override
+    {
+        cv::Mat::getStdAllocator()->deallocate(data);
+    }
+};
+
+struct PerfCase
+{
+    std::string name; // baseline key: letters, digits and '_', starting with a letter
+    SceneConfig scene;
+    TrackingMode tracking = TrackingMode::None;
+    int frames = 6; // distinct frames in the corpus
+    int rounds = 3; // measured passes over the corpus, after one warm-up pass
+};
+
+struct CaseResult
+{
+    double frame_ms = 0.0;      // median steady-state time per frame
+    double reference_ms = 0.0;  // reference workload time on the same machine, just before
+    double allocations = 0.0;   // allocations per frame, steady state
+    double recall = 0.0;        // fraction of the rendered markers that were detected
+};
+
+// Bounds every case must meet, recorded or not. Recall and allocations don't depend on the machine; the
+// time is normalized by the reference workload. Allocations and time are per megapixel of the frame.
+struct Limits
+{
+    double min_recall = 0.9;
+    double max_allocations_per_megapixel = 20000.0;
+    double max_cost_per_megapixel = 8.0; // frame time / reference workload time
+};
+
+struct Baseline
+{
+    double time_tolerance = 0.25; // allowed relative increase of the normalized frame time
+    // Allowed absolute increase of allocations per frame. The corpus and the detector are deterministic,
+    // so the count only moves when the code does; below one, a single new per-frame allocation fails.
+    double allocation_slack = 0.5;
+    double recall_tolerance = 0.01; // allowed absolute decrease of recall
+    Limits limits;
+    std::string build_type;
+    std::map<std::string, CaseResult> cases;
+};
+
+bool g_update = false;
+Baseline g_baseline;
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double median(std::vector<double> values)
+{
+    std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+    return values[values.size() / 2];
+}
+
+// The image operations detection is made of, on a fixed FHD image
+double referenceMs()
+{
+    cv::Mat image(1080, 1920, CV_8UC3), gray, blurred, binary;
+    cv::RNG(1).fill(image, cv::RNG::UNIFORM, 0, 256);
+    std::vector<double> times;
+    for (int i = 0; i < 11; ++i)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+        cv::GaussianBlur(gray, blurred, cv::Size(5, 5), 0);
+        cv::adaptiveThreshold(blurred, binary, 255, cv::ADAPTIVE_THRESH_MEAN_C, cv::THRESH_BINARY_INV, 23, 7);
+        times.push_back(elapsedMs(start));
+    }
+    return median(times);
+}
+
+CaseResult measure(const PerfCase &perf_case)
+{
+    auto calibration = makePinholeCalibration(perf_case.scene.image_size);
+    SceneGenerator generator(perf_case.scene, calibration);
+    std::vector<cv::Mat> images(perf_case.frames);
+    std::vector<std::vector<SceneMarker>> truth(perf_case.frames);
+    for (int i = 0; i < perf_case.frames; ++i)
+    {
+        generator.render(images[i], truth[i]);
+    }
+
+    DetectorConfig config;
+    config.dictionary_name = perf_case.scene.dictionary_name;
+    config.dictionary = cv::aruco::getPredefinedDictionary(dictNameToEnum(config.dictionary_name));
+    config.parameters = cv::makePtr<cv::aruco::DetectorParameters>();
+    config.marker_size = perf_case.scene.marker_size;
+    const std::string encoding = perf_case.scene.color ? "bgr8" : "mono8";
+
+    TrackingConfig tracking;
+    tracking.mode = perf_case.tracking;
+    MarkerDetector detector(tracking);
+    FrameState state;
+    std::vector<MarkerDetection> detections;
+
+    CaseResult result;
+    result.reference_ms = referenceMs();
+    std::vector<double> times;
+    size_t expected = 0, found = 0;
+    uint64_t seq = 0;
+    for (int round = 0; round <= perf_case.rounds; ++round)
+    {
+        const bool measured = round > 0;
+        for (int i = 0; i < perf_case.frames; ++i)
+        {
+            g_counting.store(measured, std::memory_order_relaxed);
+            const auto start = std::chrono::steady_clock::now();
+            detector.process(seq++, images[i], encoding, *calibration, config, state, detections);
+            const double ms = elapsedMs(start);
+            g_counting.store(false, std::memory_order_relaxed);
+            if (!measured)
+            {
+                continue;
+            }
+            times.push_back(ms);
+            expected += truth[i].size();
+            for (const SceneMarker &marker : truth[i])
+            {
+                found += std::any_of(detections.begin(), detections.end(),
+                                     [&](const MarkerDetection &detection) { return detection.id == marker.id; });
+            }
+        }
+    }
+    result.frame_ms = median(times);
+    result.allocations = static_cast<double>(g_allocations.exchange(0)) / times.size();
+    result.recall = expected > 0 ? static_cast<double>(found) / expected : 1.0;
+    return result;
+}
+
+std::map<std::string, CaseResult> &measuredCases()
+{
+    static std::map<std::string, CaseResult> cases;
+    return cases;
+}
+
+void checkCase(const PerfCase &perf_case)
+{
+    g_allocations.store(0);
+    const CaseResult result = measure(perf_case);
+    measuredCases()[perf_case.name] = result;
+    std::cout << perf_case.name << ": " << result.frame_ms << " ms/frame (" << 1000.0 / result.frame_ms
+              << " fps, reference " << result.reference_ms << " ms), " << result.allocations
+              << " allocations/frame, recall " << result.recall << std::endl;
+    if (g_update)
+    {
+        return;
+    }
+
+    const Limits &limits = g_baseline.limits;
+    const double megapixels = perf_case.scene.image_size.area() / 1e6;
+    const double cost = result.frame_ms / result.reference_ms;
+    EXPECT_GE(result.recall, limits.min_recall) << "Recall below the limit";
+    EXPECT_LE(result.allocations, limits.max_allocations_per_megapixel * megapixels)
+        << "Allocations per frame above the limit";
+
+    const auto base = g_baseline.cases.find(perf_case.name);
+    const bool recorded = base != g_baseline.cases.end();
+    const bool same_build = recorded && g_baseline.build_type == ARUCO_PERF_BUILD_TYPE;
+    if (!same_build)
+    {
+        // Times recorded in another build type are not comparable, so only the limit applies
+        EXPECT_LE(cost, limits.max_cost_per_megapixel * megapixels)
+            << "Per-frame time above the limit: " << result.frame_ms << " ms, normalized " << cost;
+    }
+    if (!recorded)
+    {
+        std::cout << "No recorded baseline for " << perf_case.name << " in " << ARUCO_PERF_BASELINE
+                  << ", only the limits were checked; record one with --update-baseline or "
+                     "ARUCO_PERF_UPDATE_BASELINE=1"
+                  << std::endl;
+        return;
+    }
+    const CaseResult &expected = base->second;
+
+    if (same_build)
+    {
+        const double baseline_cost = expected.frame_ms / expected.reference_ms;
+        EXPECT_LE(cost, baseline_cost * (1.0 + g_baseline.time_tolerance))
+            << "Per-frame time regressed: " << result.frame_ms << " ms against " << expected.frame_ms
+            << " ms in the baseline (normalized " << cost << " against " << baseline_cost << ")";
+    }
+    else
+    {
+        std::cout << "Baseline times were recorded for build type '" << g_baseline.build_type << "', this is '"
+                  << ARUCO_PERF_BUILD_TYPE << "'; only the time limit was checked" << std::endl;
+    }
+    EXPECT_LE(result.allocations, expected.allocations + g_baseline.allocation_slack)
+        << "Allocations per frame regressed: " << result.allocations << " against " << expected.allocations
+        << " in the baseline";
+    EXPECT_GE(result.recall, expected.recall - g_baseline.recall_tolerance) << "Recall regressed";
+}
+
+// Leaves `value` unchanged when the key is missing
+void readIfPresent(const cv::FileNode &node, double &value)
+{
+    if (!node.empty())
+    {
+        node >> value;
+    }
+}
+
+bool loadBaseline(const std::string &path, Baseline &baseline)
+{
+    if (!std::filesystem::exists(path))
+    {
+        return false;
+    }
+    cv::FileStorage fs(path, cv::FileStorage::READ);
+    if (!fs.isOpened())
+    {
+        return false;
+    }
+    readIfPresent(fs["time_tolerance"], baseline.time_tolerance);
+    readIfPresent(fs["allocation_slack"], baseline.allocation_slack);
+    readIfPresent(fs["recall_tolerance"], baseline.recall_tolerance);
+    const cv::FileNode limits = fs["limits"];
+    readIfPresent(limits["min_recall"], baseline.limits.min_recall);
+    readIfPresent(limits["max_allocations_per_megapixel"], baseline.limits.max_allocations_per_megapixel);
+    readIfPresent(limits["max_cost_per_megapixel"], baseline.limits.max_cost_per_megapixel);
+    fs["build_type"] >> baseline.build_type;
+    const cv::FileNode cases = fs["cases"];
+    for (auto it = cases.begin(); it != cases.end(); ++it)
+    {
+        const cv::FileNode node = *it;
+        CaseResult &result = baseline.cases[node.name()];
+        node["frame_ms"] >> result.frame_ms;
+        node["reference_ms"] >> result.reference_ms;
+        node["allocations"] >> result.allocations;
+        node["recall"] >> result.recall;
+    }
+    return true;
+}
+
+bool saveBaseline(const std::string &path, const Baseline &baseline)
+{
+    cv::FileStorage fs(path, cv::FileStorage::WRITE);
+    if (!fs.isOpened())
+    {
+        return false;
+    }
+    fs << "time_tolerance" << baseline.time_tolerance;
+    fs << "allocation_slack" << baseline.allocation_slack;
+    fs << "recall_tolerance" << baseline.recall_tolerance;
+    fs << "limits" << "{";
+    fs << "min_recall" << baseline.limits.min_recall;
+    fs << "max_allocations_per_megapixel" << baseline.limits.max_allocations_per_megapixel;
+    fs << "max_cost_per_megapixel" << baseline.limits.max_cost_per_megapixel;
+    fs << "}";
+    fs << "build_type" << baseline.build_type;
+    fs << "cases" << "{";
+    for (const auto &[name, result] : baseline.cases)
+    {
+        fs << name << "{";
+        fs << "frame_ms" << result.frame_ms;
+        fs << "reference_ms" << result.reference_ms;
+        fs << "allocations" << result.allocations;
+        fs << "recall" << result.recall;
+        fs << "}";
+    }
+    fs << "}";
+    return true;
+}
+
+SceneConfig sceneConfig(const cv::Size &size, const std::string &dictionary, int markers)
+{
+    SceneConfig scene;
+    scene.image_size = size;
+    scene.dictionary_name = dictionary;
+    scene.marker_count = markers;
+    scene.max_tilt_deg = 30.0;
+    scene.blur_sigma = 0.6;
+    scene.noise_sigma = 3.0;
+    scene.clutter = 20;
+    return scene;
+}
+
+} // namespace
+
+void *operator new(size_t size)
+{
+    countAllocation();
+    if (void *p = std::malloc(size ? size : 1))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST(Performance, VgaFewMarkers)
+{
+    checkCase({"vga_10", sceneConfig({640, 480}, "DICT_ARUCO_ORIGINAL", 10)});
+}
+
+TEST(Performance, FhdManyMarkers)
+{
+    checkCase({"fhd_50", sceneConfig({1920, 1080}, "DICT_4X4_250", 50)});
+}
+
+TEST(Performance, UhdManyMarkers)
+{
+    checkCase({"uhd_100", sceneConfig({3840, 2160}, "DICT_4X4_250", 100), TrackingMode::None, 3, 2});
+}
+
+TEST(Performance, FhdMonoInput)
+{
+    SceneConfig scene = sceneConfig({1920, 1080}, "DICT_4X4_250", 50);
+    scene.color = false;
+    checkCase({"fhd_50_mono", scene});
+}
+
+// A static scene tracked from frame to frame: mostly ROI detection, with a full scan every 10 frames
+TEST(Performance, FhdRoiTracking)
+{
+    checkCase({"fhd_50_roi", sceneConfig({1920, 1080}, "DICT_4X4_250", 50), TrackingMode::Roi, 1, 30});
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    for (int i = 1; i < argc; ++i)
+    {
+        g_update = g_update || std::string(argv[i]) == "--update-baseline";
+    }
+    if (const char *env = std::getenv("ARUCO_PERF_UPDATE_BASELINE"))
+    {
+        g_update = g_update || (*env != '\0' && std::string(env) != "0");
+    }
+
+    // One thread, so that timings and allocation counts don't depend on the core count and load
+    cv::setNumThreads(1);
+    static CountingMatAllocator allocator;
+    cv::Mat::setDefaultAllocator(&allocator);
+    if (!loadBaseline(ARUCO_PERF_BASELINE, g_baseline) && !g_update)
+    {
+        std::cerr << "Could not read " << ARUCO_PERF_BASELINE << std::endl;
+        return 1;
+    }
+
+    const int status = RUN_ALL_TESTS();
+    if (g_update && status == 0)
+    {
+        // Cases that didn't run (e.g. filtered out) keep their previous values
+        g_baseline.build_type = ARUCO_PERF_BUILD_TYPE;
+        for (const auto &[name, result] : measuredCases())
+        {
+            g_baseline.cases[name] = result;
+        }
+        if (!saveBaseline(ARUCO_PERF_BASELINE, g_baseline))
+        {
+            std::cerr << "Could not write " << ARUCO_PERF_BASELINE << std::endl;
+            return 1;
+        }
+        std::cout << "Baseline written to " << ARUCO_PERF_BASELINE << std::endl;
+    }
+    return status;
+}